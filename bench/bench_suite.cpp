@@ -0,0 +1,514 @@
+// 综合基准测试：分别测量词法分析吞吐量、建表耗时随文法规模的变化、语法分析吞吐量及每个Token的内存分配次数，
+// 以及增量分析中单次编辑的延迟。
+// 输入由内置文法(SyntaxParser::initializeProductions)随机推导生成，结果以JSON输出到标准输出，便于跟踪性能回归。
+// 用法: bench_suite [--max-mb N] [--max-tree-mb N] [--max-scale N] [--seed N]
+#include "../src/parser/parser.cpp"
+#include "../src/parser/incremental_parser.h"
+#include "../src/parser/split_parser.h"
+#include "synthetic_grammar.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <random>
+
+using namespace std;
+
+// ---------------- 内存分配计数 ----------------
+
+// 替换全局operator new，统计分析过程中的分配次数和字节数
+static atomic<uint64_t> allocationCount{0};
+static atomic<uint64_t> allocationBytes{0};
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    allocationBytes.fetch_add(size, memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+
+// GCC把内联后的operator new与free配对检查，对替换的全局分配函数会误报
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+struct AllocationSnapshot {
+    uint64_t count;
+    uint64_t bytes;
+
+    static AllocationSnapshot now() {
+        return {allocationCount.load(memory_order_relaxed), allocationBytes.load(memory_order_relaxed)};
+    }
+};
+
+// ---------------- 由文法生成输入 ----------------
+
+// 从内置文法随机推导语句。推导深度超过上限后只选最矮的产生式，保证推导终止
+class SourceGenerator {
+private:
+    unordered_map<string, vector<const Production*>> productionsByLeft;
+    unordered_map<string, int> height;   // 非终结符推导出终结符串所需的最小深度
+    vector<Production> productions;
+    mt19937 rng;
+    int maxDepth;
+
+    bool isNonTerminal(const string& symbol) const { return productionsByLeft.count(symbol) != 0; }
+
+    int productionHeight(const Production& prod) const {
+        int h = 0;
+        for (const string& symbol : prod.right) {
+            if (!isNonTerminal(symbol)) continue;
+            auto it = height.find(symbol);
+            if (it == height.end()) return INT32_MAX;
+            h = max(h, it->second);
+        }
+        return h + 1;
+    }
+
+    void computeHeights() {
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (const Production& prod : productions) {
+                int h = productionHeight(prod);
+                if (h == INT32_MAX) continue;
+                auto it = height.find(prod.left);
+                if (it == height.end() || h < it->second) {
+                    height[prod.left] = h;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    void emitTerminal(const string& terminal, string& out) {
+        if (terminal == "ε") return;
+        if (terminal == "IDENTIFIER") {
+            out += "v" + to_string(rng() % 4096);
+        } else if (terminal == "NUMBER") {
+            out += rng() % 2 ? to_string(rng() % 100000) : to_string(rng() % 1000) + "." + to_string(rng() % 100);
+        } else if (terminal == "STRING") {
+            out += "\"s" + to_string(rng() % 100) + "\"";
+        } else {
+            out += terminal;
+        }
+        out += (terminal == ";" || terminal == "{" || terminal == "}") ? '\n' : ' ';
+    }
+
+    void derive(const string& symbol, int depth, string& out) {
+        auto it = productionsByLeft.find(symbol);
+        if (it == productionsByLeft.end()) {
+            emitTerminal(symbol, out);
+            return;
+        }
+        const vector<const Production*>& candidates = it->second;
+        const Production* chosen = candidates[rng() % candidates.size()];
+        if (depth >= maxDepth) {
+            for (const Production* prod : candidates) {
+                if (productionHeight(*prod) < productionHeight(*chosen)) chosen = prod;
+            }
+        }
+        for (const string& rhsSymbol : chosen->right) {
+            derive(rhsSymbol, depth + 1, out);
+        }
+    }
+
+public:
+    SourceGenerator(vector<Production> prods, uint32_t seed, int maxDepth = 10)
+        : productions(move(prods)), rng(seed), maxDepth(maxDepth) {
+        for (const Production& prod : productions) {
+            productionsByLeft[prod.left].push_back(&prod);
+        }
+        computeHeights();
+    }
+
+    // 生成不少于bytes字节的程序，并记录每条顶层语句结束的位置，便于截取不同规模的合法前缀
+    string generate(size_t bytes, vector<size_t>& statementEnds) {
+        string out;
+        out.reserve(bytes + 4096);
+        while (out.size() < bytes) {
+            derive("Statement", 1, out);
+            statementEnds.push_back(out.size());
+        }
+        return out;
+    }
+};
+
+// 截取不短于bytes、且在顶层语句边界结束的前缀
+static string_view prefixOf(const string& source, const vector<size_t>& statementEnds, size_t bytes) {
+    auto it = lower_bound(statementEnds.begin(), statementEnds.end(), bytes);
+    size_t end = it == statementEnds.end() ? source.size() : *it;
+    return string_view(source).substr(0, end);
+}
+
+// 在合法输入中随机删除几段字符或插入几个符号，得到带语法错误的输入
+static string corruptSource(string_view source, mt19937& rng) {
+    static const char* const symbols[] = {";", ",", "=", "+", "==", "(", ")", "{", "}", "[", "]",
+                                          "if", "else", "while", "for", "return", "int", "x", "1"};
+    string out(source);
+    for (int edits = 1 + rng() % 3; edits > 0; --edits) {
+        size_t at = rng() % (out.size() + 1);
+        if (rng() % 2) {
+            out.erase(at, 1 + rng() % 8);
+        } else {
+            out.insert(at, string(" ") + symbols[rng() % size(symbols)] + " ");
+        }
+    }
+    return out;
+}
+
+// 分析得到的事件序列和诊断，逐项写成一个字符串便于比较
+static string describeParse(const shared_ptr<const CompiledGrammar>& grammar, string_view source) {
+    string result;
+    SyntaxParser parser(grammar, Lexer(source));
+    auto sink = makeEventSink([&result](const ParseEvent& event) {
+        result += to_string(event.type) + " " + to_string(event.production) + " " + to_string(event.symbol) + " " +
+                  to_string(event.span.begin) + " " + to_string(event.span.end) + "\n";
+    });
+    parser.parse(sink);
+    for (const ParseDiagnostic& diagnostic : parser.diagnostics()) {
+        result += to_string(diagnostic.offset) + ": " + diagnostic.message + "\n";
+    }
+    return result;
+}
+
+// ---------------- 测量 ----------------
+
+// 防止被测循环被编译器优化掉
+static volatile uint64_t benchSink = 0;
+
+static double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// 小输入重复多次，使每项测量处理的总字节数接近targetBytes
+static int roundsFor(size_t bytes, size_t targetBytes) {
+    return static_cast<int>(min<size_t>(1000, max<size_t>(1, targetBytes / max<size_t>(bytes, 1))));
+}
+
+static size_t countTokens(string_view source) {
+    Lexer lexer(source);
+    size_t tokens = 0;
+    for (Token token = lexer.next(); token.kind != TK_END; token = lexer.next()) tokens++;
+    return tokens;
+}
+
+static void measureLexer(ostream& out, string_view source) {
+    const int rounds = roundsFor(source.size(), 64u << 20);
+    size_t tokens = 0;
+    uint64_t checksum = 0;
+    auto start = chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        Lexer lexer(source);
+        tokens = 0;
+        for (Token token = lexer.next(); token.kind != TK_END; token = lexer.next()) {
+            tokens++;
+            checksum += token.kind + token.offset;
+        }
+    }
+    double seconds = secondsSince(start) / rounds;
+    benchSink = checksum;
+    out << "{\"bytes\": " << source.size() << ", \"tokens\": " << tokens << ", \"rounds\": " << rounds
+        << ", \"seconds\": " << seconds << ", \"mb_per_s\": " << source.size() / seconds / (1 << 20) << "}";
+}
+
+template <typename Parse>
+static void measureParse(ostream& out, const char* sinkName, string_view source, size_t tokens, Parse parse) {
+    const int rounds = roundsFor(source.size(), 16u << 20);
+    AllocationSnapshot before = AllocationSnapshot::now();
+    auto start = chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        benchSink = parse(source);
+    }
+    double seconds = secondsSince(start) / rounds;
+    AllocationSnapshot after = AllocationSnapshot::now();
+    double allocations = static_cast<double>(after.count - before.count) / rounds;
+    double bytes = static_cast<double>(after.bytes - before.bytes) / rounds;
+    out << "{\"sink\": \"" << sinkName << "\", \"bytes\": " << source.size() << ", \"tokens\": " << tokens
+        << ", \"rounds\": " << rounds << ", \"seconds\": " << seconds
+        << ", \"tokens_per_s\": " << tokens / seconds << ", \"mb_per_s\": " << source.size() / seconds / (1 << 20)
+        << ", \"allocations\": " << allocations << ", \"allocations_per_token\": " << allocations / tokens
+        << ", \"allocated_bytes_per_token\": " << bytes / tokens << "}";
+}
+
+static void measureTableBuild(ostream& out, const string& name, const vector<Production>& productions,
+                              const unordered_set<string>& nonTerminals, const unordered_set<string>& terminals,
+                              const string& start, size_t threads) {
+    const int rounds = productions.size() < 256 ? 20 : 1;
+    int states = 0;
+    auto begin = chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        GrammarTables tables = buildGrammarTables(productions, nonTerminals, terminals, start, threads);
+        states = tables.table.numStates;
+    }
+    double ms = secondsSince(begin) * 1000 / rounds;
+    out << "{\"grammar\": \"" << name << "\", \"productions\": " << productions.size()
+        << ", \"terminals\": " << terminals.size() << ", \"states\": " << states
+        << ", \"threads\": " << threads << ", \"ms\": " << ms << "}";
+}
+
+// 两棵语法树的结构、符号和区间逐个节点相同
+static bool sameTree(const SyntaxTreeNode* a, const SyntaxTreeNode* b) {
+    vector<pair<const SyntaxTreeNode*, const SyntaxTreeNode*>> pending = {{a, b}};
+    while (!pending.empty()) {
+        const SyntaxTreeNode* x = pending.back().first;
+        const SyntaxTreeNode* y = pending.back().second;
+        pending.pop_back();
+        if (x == nullptr || y == nullptr) {
+            if (x != y) return false;
+            continue;
+        }
+        if (x->symbol != y->symbol || x->begin != y->begin || x->end != y->end || x->childCount != y->childCount) {
+            return false;
+        }
+        for (uint32_t i = 0; i < x->childCount; ++i) pending.push_back({x->children[i], y->children[i]});
+    }
+    return true;
+}
+
+static bool sameDiagnostics(const vector<ParseDiagnostic>& a, const vector<ParseDiagnostic>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].line != b[i].line || a[i].offset != b[i].offset || a[i].message != b[i].message) return false;
+    }
+    return true;
+}
+
+// 增量分析的语法树和诊断须与对同一文本完整分析的结果相同
+static bool matchesFullParse(const shared_ptr<const CompiledGrammar>& grammar, const IncrementalParser& parser) {
+    SyntaxParser full(grammar, Lexer(string_view(parser.text())));
+    SyntaxTree expected = full.parse();
+    SyntaxTree actual = parser.toSyntaxTree();
+    return sameTree(actual.root(), expected.root()) && sameDiagnostics(parser.diagnostics(), full.diagnostics());
+}
+
+// 测量单次编辑的增量分析延迟，编辑依次轮换三类：
+//   digit     改写数字字面量的一位，Token结构不变
+//   token     在空白处插入一个Token(多半造成语法错误)，随后撤销
+//   statement 删除一条简单语句(以';'结尾，其中没有'{'、'}')，随后恢复
+// 每次编辑后与完整分析的结果比较，不一致时返回false；大输入完整分析较慢，每隔若干次编辑比较一次
+static bool measureIncremental(ostream& out, const shared_ptr<const CompiledGrammar>& grammar, string_view source,
+                               uint32_t seed) {
+    static const char* const insertedTokens[] = {";", "=", "+", "(", ")", "{", "}", "if", "else", "while",
+                                                 "int", "x", "1", "x = 1;"};
+    enum EditKind { DIGIT_EDIT, TOKEN_EDIT, STATEMENT_EDIT, EDIT_KINDS };
+    static const char* const kindNames[EDIT_KINDS] = {"digit", "token", "statement"};
+
+    auto start = chrono::steady_clock::now();
+    IncrementalParser parser(grammar, string(source));
+    double fullSeconds = secondsSince(start);
+
+    mt19937 rng(seed);
+    const int rounds = 99;
+    const int verifyEvery = source.size() <= (1u << 20) ? 1 : 25;
+    int edits = 0;
+    int kindEdits[EDIT_KINDS] = {};
+    double kindSeconds[EDIT_KINDS] = {};
+    size_t reused = 0, shifted = 0, relexed = 0, fullParses = 0;
+
+    auto apply = [&](EditKind kind, size_t offset, size_t removed, string_view inserted) {
+        const auto editStart = chrono::steady_clock::now();
+        parser.edit(offset, removed, inserted);
+        kindSeconds[kind] += secondsSince(editStart);
+        kindEdits[kind]++;
+        const IncrementalStats& stats = parser.lastStats();
+        reused += stats.reusedSubtrees;
+        shifted += stats.shiftedTokens;
+        relexed += stats.relexedTokens;
+        fullParses += stats.fullParse;
+        if (++edits % verifyEvery != 0) return true;
+        if (matchesFullParse(grammar, parser)) return true;
+        cerr << "Incremental parse differs from a full parse after a " << kindNames[kind] << " edit at offset "
+             << offset << " (removed " << removed << ", inserted \"" << inserted << "\")" << endl;
+        return false;
+    };
+
+    setTraceLevel(TRACE_OFF);  // 插入的Token造成的语法错误是预期之中的
+    bool ok = true;
+    for (int i = 0; i < rounds && ok; ++i) {
+        const string& text = parser.text();
+        size_t offset = rng() % text.size();
+        switch (static_cast<EditKind>(i % EDIT_KINDS)) {
+            case DIGIT_EDIT: {
+                while (offset < text.size() && !isdigit(static_cast<unsigned char>(text[offset]))) offset++;
+                if (offset == text.size()) offset = text.find_first_of("0123456789");
+                ok = apply(DIGIT_EDIT, offset, 1, to_string(rng() % 10));
+                break;
+            }
+            case TOKEN_EDIT: {
+                while (offset < text.size() && !isspace(static_cast<unsigned char>(text[offset]))) offset++;
+                const string token = string(" ") + insertedTokens[rng() % size(insertedTokens)];
+                ok = apply(TOKEN_EDIT, offset, 0, token) && apply(TOKEN_EDIT, offset, token.size(), "");
+                break;
+            }
+            case STATEMENT_EDIT:
+            default: {
+                size_t end = text.find(';', offset);
+                if (end == string::npos) end = text.find(';');
+                if (end == string::npos) break;
+                // 语句从前一个';'、'{'或'}'之后开始(没有时从文本开头)
+                const size_t begin = end == 0 ? 0 : text.find_last_of(";{}", end - 1) + 1;
+                const string statement = text.substr(begin, end + 1 - begin);
+                ok = apply(STATEMENT_EDIT, begin, statement.size(), "") && apply(STATEMENT_EDIT, begin, 0, statement);
+                break;
+            }
+        }
+    }
+    if (ok && edits % verifyEvery != 0 && !matchesFullParse(grammar, parser)) {
+        cerr << "Incremental parse differs from a full parse after the last edit" << endl;
+        ok = false;
+    }
+    setTraceLevel(TRACE_ERROR);
+
+    double totalSeconds = 0;
+    for (double seconds : kindSeconds) totalSeconds += seconds;
+    out << "{\"bytes\": " << source.size() << ", \"initial_seconds\": " << fullSeconds
+        << ", \"edits\": " << edits << ", \"edit_seconds\": " << totalSeconds / max(edits, 1);
+    for (int kind = 0; kind < EDIT_KINDS; ++kind) {
+        out << ", \"" << kindNames[kind] << "_edit_seconds\": " << kindSeconds[kind] / max(kindEdits[kind], 1);
+    }
+    out << ", \"reused_subtrees_per_edit\": " << static_cast<double>(reused) / max(edits, 1)
+        << ", \"shifted_tokens_per_edit\": " << static_cast<double>(shifted) / max(edits, 1)
+        << ", \"relexed_tokens_per_edit\": " << static_cast<double>(relexed) / max(edits, 1)
+        << ", \"full_reparses\": " << fullParses << "}";
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    size_t maxMb = 64;
+    size_t maxTreeMb = 16;
+    int maxScale = 256;
+    uint32_t seed = 2024;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string arg = argv[i];
+        if (arg == "--max-mb") maxMb = static_cast<size_t>(atoi(argv[i + 1]));
+        else if (arg == "--max-tree-mb") maxTreeMb = static_cast<size_t>(atoi(argv[i + 1]));
+        else if (arg == "--max-scale") maxScale = atoi(argv[i + 1]);
+        else if (arg == "--seed") seed = static_cast<uint32_t>(atoi(argv[i + 1]));
+        else {
+            cerr << "Usage: " << argv[0] << " [--max-mb N] [--max-tree-mb N] [--max-scale N] [--seed N]" << endl;
+            return 2;
+        }
+    }
+
+    // 输入规模从64KB起按8倍递增，直到maxMb
+    vector<size_t> sizes;
+    for (size_t bytes = 64u << 10; bytes <= (maxMb << 20); bytes *= 8) sizes.push_back(bytes);
+    if (sizes.empty() || sizes.back() != (maxMb << 20)) sizes.push_back(maxMb << 20);
+
+    // 按展开重复符号之后的产生式推导
+    SourceGenerator generator(SyntaxParser::buildSLRTable().productions, seed);
+    vector<size_t> statementEnds;
+    const string source = generator.generate(sizes.back(), statementEnds);
+
+    shared_ptr<const CompiledGrammar> grammar = SyntaxParser::compileGrammar();
+
+    // 生成的输入必须能被分析表无错误地接受，否则测得的是错误恢复而不是正常分析
+    {
+        SyntaxParser parser(grammar, Lexer(string_view(source)));
+        auto sink = makeEventSink([](const ParseEvent&) {});
+        parser.parse(sink);
+        if (!parser.diagnostics().empty()) {
+            cerr << "Generated input is rejected at line " << parser.diagnostics().front().line << ": "
+                 << parser.diagnostics().front().message << endl;
+            return 1;
+        }
+    }
+
+    // 压缩表与稠密表在出错输入上也必须给出相同的事件序列和诊断，即在同一位置发现错误、同一位置恢复
+    {
+        shared_ptr<const CompiledGrammar> compressed = SyntaxParser::compileGrammar(COMPRESSED_TABLE);
+        string_view sample = prefixOf(source, statementEnds, 4u << 10);
+        mt19937 rng(seed);
+        setTraceLevel(TRACE_OFF);  // 不逐条打印预期之中的语法错误
+        for (int i = 0; i < 2000; ++i) {
+            const string input = corruptSource(sample, rng);
+            if (describeParse(grammar, input) != describeParse(compressed, input)) {
+                cerr << "Compressed and dense tables disagree on erroneous input #" << i << ":\n" << input << endl;
+                return 1;
+            }
+        }
+        setTraceLevel(TRACE_ERROR);
+    }
+
+    ostream& out = cout;
+    out << "{\n  \"seed\": " << seed << ",\n  \"threads\": " << thread::hardware_concurrency() << ",\n";
+
+    out << "  \"lexer\": [";
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        out << (i ? ",\n    " : "\n    ");
+        measureLexer(out, prefixOf(source, statementEnds, sizes[i]));
+    }
+    out << "\n  ],\n";
+
+    out << "  \"table_build\": [";
+    {
+        auto productions = SyntaxParser::initializeProductions();
+        out << "\n    ";
+        measureTableBuild(out, "builtin", productions, SyntaxParser::getNonTerminals(productions),
+                          SyntaxParser::getTerminals(), "S'", thread::hardware_concurrency());
+    }
+    for (int scale = 1; scale <= maxScale; scale *= 2) {
+        SyntheticGrammar g = makeGrammar(scale);
+        for (size_t threads : {size_t(1), size_t(thread::hardware_concurrency())}) {
+            out << ",\n    ";
+            measureTableBuild(out, "synthetic-" + to_string(scale), g.productions, g.nonTerminals, g.terminals,
+                              "S'", threads);
+        }
+    }
+    out << "\n  ],\n";
+
+    ThreadPool pool;  // 单文件切分并行分析所用
+    ParseStackPool<TreeSink::Value> stacks;  // 各轮分析复用的分析栈
+    out << "  \"parse\": [";
+    bool first = true;
+    for (size_t bytes : sizes) {
+        string_view input = prefixOf(source, statementEnds, bytes);
+        const size_t tokens = countTokens(input);
+        out << (first ? "\n    " : ",\n    ");
+        first = false;
+        measureParse(out, "events", input, tokens, [&grammar](string_view text) {
+            SyntaxParser parser(grammar, Lexer(text));
+            auto sink = makeEventSink([](const ParseEvent&) {});
+            return static_cast<uint64_t>(parser.parse(sink).end);
+        });
+        if (bytes > (maxTreeMb << 20)) continue;  // 语法树的内存约为输入的数十倍
+        out << ",\n    ";
+        measureParse(out, "flat", input, tokens, [&grammar](string_view text) {
+            SyntaxParser parser(grammar, Lexer(text));
+            FlatSink sink;
+            return static_cast<uint64_t>(parser.parse(sink).nodes.size());
+        });
+        out << ",\n    ";
+        measureParse(out, "tree", input, tokens, [&grammar](string_view text) {
+            SyntaxParser parser(grammar, Lexer(text));
+            return static_cast<uint64_t>(parser.parse().memoryBytes());
+        });
+        out << ",\n    ";
+        measureParse(out, "tree-pooled", input, tokens, [&grammar, &stacks](string_view text) {
+            SyntaxParser parser(grammar, Lexer(text));
+            return static_cast<uint64_t>(parser.parse(stacks).memoryBytes());
+        });
+        out << ",\n    ";
+        measureParse(out, "tree-split", input, tokens, [&grammar, &pool](string_view text) {
+            return static_cast<uint64_t>(parseSplit(grammar, Lexer(text), pool).memoryBytes());
+        });
+    }
+    out << "\n  ],\n";
+
+    out << "  \"incremental\": [";
+    first = true;
+    for (size_t bytes : sizes) {
+        if (bytes > (maxTreeMb << 20)) break;
+        out << (first ? "\n    " : ",\n    ");
+        first = false;
+        if (!measureIncremental(out, grammar, prefixOf(source, statementEnds, bytes), seed)) return 1;
+    }
+    out << "\n  ]\n}" << endl;
+    return 0;
+}
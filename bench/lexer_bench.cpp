@@ -0,0 +1,102 @@
+// 词法分析基准测试：比较标量扫描与SIMD扫描(SSE2/AVX2)的吞吐量
+// 用法: lexer_bench [输入大小(MB)]
+#include "../src/lexer/lexer.cpp"
+#include <chrono>
+#include <cstdlib>
+#include <random>
+
+using namespace std;
+
+// 合成输入：长空白缩进、行注释、块注释、长标识符和数字交替出现
+static string makeInput(size_t bytes) {
+    mt19937 rng(2024);
+    uniform_int_distribution<int> pick(0, 5);
+    uniform_int_distribution<int> width(4, 48);
+    string text;
+    text.reserve(bytes + 256);
+    while (text.size() < bytes) {
+        text.append(static_cast<size_t>(width(rng)), ' ');
+        switch (pick(rng)) {
+            case 0:
+                text += "// " + string(static_cast<size_t>(width(rng)) * 2, 'c') + "\n";
+                break;
+            case 1:
+                text += "/* " + string(static_cast<size_t>(width(rng)), 'b') + "\n   "
+                      + string(static_cast<size_t>(width(rng)), 'b') + " */\n";
+                break;
+            case 2:
+                text += "float value_" + string(static_cast<size_t>(width(rng)), 'x') + "_total;\n";
+                break;
+            case 3:
+                text += "y = " + to_string(rng()) + to_string(rng()) + "." + to_string(rng()) + ";\n";
+                break;
+            case 4:
+                text += "if (counter >= limit && flag) { x += 1; }\n";
+                break;
+            default:
+                text += "\n\t\n";
+                break;
+        }
+    }
+    return text;
+}
+
+// 防止词法分析循环被编译器优化掉
+static volatile uint64_t benchSink = 0;
+
+struct LexResult {
+    double seconds = 0;
+    size_t tokens = 0;
+    uint64_t checksum = 0;
+};
+
+static LexResult measure(const string& input, const ScanKernels& kernels, int rounds) {
+    LexResult result;
+    auto start = chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        Lexer lexer(input);
+        lexer.useScanKernels(kernels);
+        result.tokens = 0;
+        result.checksum = 0;
+        for (Token token = lexer.next(); token.kind != TK_END; token = lexer.next()) {
+            result.tokens++;
+            result.checksum = result.checksum * 31 + token.kind + token.offset * 7 + token.line * 13 + token.value.size();
+        }
+    }
+    auto end = chrono::steady_clock::now();
+    result.seconds = chrono::duration<double>(end - start).count() / rounds;
+    return result;
+}
+
+int main(int argc, char** argv) {
+    size_t megabytes = argc > 1 ? static_cast<size_t>(atoi(argv[1])) : 32;
+    string input = makeInput(megabytes << 20);
+    const int rounds = 5;
+
+    vector<const ScanKernels*> variants = {&scalarScanKernels()};
+#ifdef SLR_SCAN_SSE2
+    variants.push_back(&sse2ScanKernels());
+#endif
+#ifdef SLR_SCAN_AVX2
+    if (__builtin_cpu_supports("avx2")) variants.push_back(&avx2ScanKernels());
+#endif
+
+    cout << "dispatch selects: " << scanKernels().name << endl;
+    cout << "kernels\tbytes\ttokens\tMB/s\tspeedup" << endl;
+    LexResult baseline;
+    for (const ScanKernels* kernels : variants) {
+        LexResult result = measure(input, *kernels, rounds);
+        if (kernels == variants.front()) {
+            baseline = result;
+        } else if (result.tokens != baseline.tokens || result.checksum != baseline.checksum) {
+            // 校验：各实现产生的Token序列(种类、位置、行号)必须与标量路径完全一致
+            cerr << "Token stream mismatch for " << kernels->name << endl;
+            return 1;
+        }
+        cout << kernels->name << "\t" << input.size() << "\t" << result.tokens << "\t"
+             << input.size() / result.seconds / (1 << 20) << "\t"
+             << baseline.seconds / result.seconds << endl;
+        benchSink = result.checksum;
+    }
+    return 0;
+}
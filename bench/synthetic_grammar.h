@@ -0,0 +1,47 @@
+#pragma once
+
+// 基准测试共用的合成文法
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "grammer.h"
+
+using namespace std;
+
+// 合成文法：规模为k时包含k组互不相同的语句/表达式产生式，状态数随k线性增长
+struct SyntheticGrammar {
+    vector<Production> productions;
+    unordered_set<string> nonTerminals;
+    unordered_set<string> terminals;
+};
+
+inline SyntheticGrammar makeGrammar(int scale) {
+    SyntheticGrammar g;
+    auto add = [&g](const string& left, const vector<string>& right) {
+        g.productions.emplace_back(left, right, static_cast<int>(g.productions.size()));
+        g.nonTerminals.insert(left);
+    };
+
+    add("S'", {"Program"});
+    add("Program", {"Statements"});
+    add("Statements", {"Statement", "Statements"});
+    add("Statements", {"Statement"});
+    for (int k = 0; k < scale; ++k) {
+        string n = to_string(k);
+        string kw = "kw" + n, op = "op" + n;
+        add("Statement", {"Stmt" + n});
+        add("Stmt" + n, {kw, "IDENTIFIER", "=", "Expr" + n, ";"});
+        add("Stmt" + n, {kw, "(", "Expr" + n, ")", "{", "Statements", "}"});
+        add("Expr" + n, {"Expr" + n, op, "Term" + n});
+        add("Expr" + n, {"Term" + n});
+        add("Term" + n, {"IDENTIFIER"});
+        add("Term" + n, {"NUMBER"});
+        add("Term" + n, {"(", "Expr" + n, ")"});
+        g.terminals.insert(kw);
+        g.terminals.insert(op);
+    }
+    for (const char* t : {"IDENTIFIER", "NUMBER", "=", ";", "(", ")", "{", "}", "$"}) {
+        g.terminals.insert(t);
+    }
+    return g;
+}
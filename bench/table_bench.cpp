@@ -0,0 +1,103 @@
+// 分析表基准测试：比较单线程与多线程建表耗时，以及稠密表与压缩表的内存占用和查表延迟
+// 用法: table_bench [最大规模] [建表线程数]
+#include "../src/slr/slr.cpp"
+#include "synthetic_grammar.h"
+#include <chrono>
+#include <cstdlib>
+#include <random>
+
+using namespace std;
+
+// 防止查表循环被编译器优化掉
+static volatile uint64_t benchSink = 0;
+
+template <typename Table>
+static double measureLookups(const Table& table, const vector<pair<int, int>>& queries, uint64_t& checksum) {
+    auto start = chrono::steady_clock::now();
+    uint64_t sum = 0;
+    for (int round = 0; round < 8; ++round) {
+        for (const auto& q : queries) {
+            sum += table.action(q.first, q.second);
+        }
+    }
+    auto end = chrono::steady_clock::now();
+    checksum += sum;
+    double ns = chrono::duration<double, nano>(end - start).count();
+    return ns / (8.0 * queries.size());
+}
+
+int main(int argc, char** argv) {
+    int maxScale = argc > 1 ? atoi(argv[1]) : 16;
+
+    const size_t threads = argc > 2 ? static_cast<size_t>(atoi(argv[2])) : thread::hardware_concurrency();
+    cout << "scale\tstates\tterminals\tbuild_1t_ms\tbuild_" << threads << "t_ms"
+         << "\tdense_bytes\tcompressed_bytes\tdense_ns\tcompressed_ns" << endl;
+    for (int scale = 1; scale <= maxScale; scale *= 2) {
+        SyntheticGrammar g = makeGrammar(scale);
+
+        ParseTable dense, parallel;
+        SLRParser slr(g.productions, g.nonTerminals, g.terminals, "S'");
+        auto buildStart = chrono::steady_clock::now();
+        slr.buildSLRTable(dense, 1);
+        auto buildMid = chrono::steady_clock::now();
+        slr.buildSLRTable(parallel, threads);
+        auto buildEnd = chrono::steady_clock::now();
+        double serialMs = chrono::duration<double, milli>(buildMid - buildStart).count();
+        double parallelMs = chrono::duration<double, milli>(buildEnd - buildMid).count();
+
+        // 校验：多线程构造的分析表(包括状态编号)必须与单线程完全相同
+        if (parallel.numStates != dense.numStates) {
+            cerr << "Parallel build produced " << parallel.numStates << " states, expected " << dense.numStates << endl;
+            return 1;
+        }
+        for (int s = 0; s < dense.numStates; ++s) {
+            for (int t = 0; t < dense.numTerminals; ++t) {
+                if (parallel.action(s, t) != dense.action(s, t)) {
+                    cerr << "Parallel build mismatch at state " << s << ", terminal " << t << endl;
+                    return 1;
+                }
+            }
+            for (int n = 0; n < dense.numNonTerminals; ++n) {
+                if (parallel.gotoState(s, dense.numTerminals + n) != dense.gotoState(s, dense.numTerminals + n)) {
+                    cerr << "Parallel build GOTO mismatch at state " << s << ", nonterminal " << n << endl;
+                    return 1;
+                }
+            }
+        }
+
+        CompressedParseTable compressed = CompressedParseTable::compress(dense);
+
+        // 校验：压缩表的每个表项(包括出错项和无转移项)都必须与稠密表一致
+        for (int s = 0; s < dense.numStates; ++s) {
+            for (int t = 0; t < dense.numTerminals; ++t) {
+                if (compressed.action(s, t) != dense.action(s, t)) {
+                    cerr << "Mismatch at state " << s << ", terminal " << t << endl;
+                    return 1;
+                }
+            }
+            for (int n = 0; n < dense.numNonTerminals; ++n) {
+                if (compressed.gotoState(s, dense.numTerminals + n) != dense.gotoState(s, dense.numTerminals + n)) {
+                    cerr << "GOTO mismatch at state " << s << ", nonterminal " << n << endl;
+                    return 1;
+                }
+            }
+        }
+
+        mt19937 rng(12345);
+        uniform_int_distribution<int> stateDist(0, dense.numStates - 1);
+        uniform_int_distribution<int> termDist(0, dense.numTerminals - 1);
+        vector<pair<int, int>> queries(1 << 20);
+        for (auto& q : queries) q = {stateDist(rng), termDist(rng)};
+
+        uint64_t checksum = 0;
+        double denseNs = measureLookups(dense, queries, checksum);
+        double compressedNs = measureLookups(compressed, queries, checksum);
+        size_t denseBytes = dense.memoryBytes();
+
+        cout << scale << "\t" << dense.numStates << "\t" << dense.numTerminals << "\t"
+             << serialMs << "\t" << parallelMs << "\t" << denseBytes << "\t" << compressed.memoryBytes() << "\t"
+             << denseNs << "\t" << compressedNs << endl;
+        benchSink = checksum;
+    }
+    return 0;
+}
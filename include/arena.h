@@ -0,0 +1,121 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+// 单调递增的区域分配器：只分配不单独释放，整个区域随对象析构一次性释放。
+// 只能存放平凡析构的对象(不会调用析构函数)；移动后已分配对象的地址不变
+class Arena {
+private:
+    struct Block {
+        unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    vector<Block> blocks;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+    size_t nextBlockSize;
+    size_t bytesUsed = 0;
+
+    void grow(size_t minimum) {
+        size_t size = nextBlockSize;
+        while (size < minimum) size *= 2;
+        blocks.push_back({unique_ptr<char[]>(new char[size]), size});
+        cursor = blocks.back().data.get();
+        limit = cursor + size;
+        nextBlockSize = size * 2;  // 块大小倍增，块数量为对数级
+    }
+
+public:
+    explicit Arena(size_t initialBlockSize = 16 * 1024) : nextBlockSize(initialBlockSize) {}
+
+    Arena(Arena&& other) noexcept
+        : blocks(move(other.blocks)), cursor(other.cursor), limit(other.limit),
+          nextBlockSize(other.nextBlockSize), bytesUsed(other.bytesUsed) {
+        other.cursor = other.limit = nullptr;
+        other.bytesUsed = 0;
+    }
+
+    Arena& operator=(Arena&& other) noexcept {
+        blocks = move(other.blocks);
+        cursor = other.cursor;
+        limit = other.limit;
+        nextBlockSize = other.nextBlockSize;
+        bytesUsed = other.bytesUsed;
+        other.cursor = other.limit = nullptr;
+        other.bytesUsed = 0;
+        return *this;
+    }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment = alignof(max_align_t)) {
+        uintptr_t aligned = (reinterpret_cast<uintptr_t>(cursor) + alignment - 1) & ~(uintptr_t(alignment) - 1);
+        if (cursor == nullptr || aligned + bytes > reinterpret_cast<uintptr_t>(limit)) {
+            grow(bytes + alignment);
+            aligned = (reinterpret_cast<uintptr_t>(cursor) + alignment - 1) & ~(uintptr_t(alignment) - 1);
+        }
+        cursor = reinterpret_cast<char*>(aligned + bytes);
+        bytesUsed += bytes;
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        static_assert(is_trivially_destructible<T>::value, "Arena objects are never destroyed");
+        return new (allocate(sizeof(T), alignof(T))) T{forward<Args>(args)...};
+    }
+
+    // 分配n个未初始化的T(n为0时返回nullptr)
+    template <typename T>
+    T* allocateArray(size_t n) {
+        static_assert(is_trivially_destructible<T>::value, "Arena objects are never destroyed");
+        if (n == 0) return nullptr;
+        return static_cast<T*>(allocate(sizeof(T) * n, alignof(T)));
+    }
+
+    // 向长度为count的数组末尾追加一个元素，返回(可能换新的)数组。容量隐式取不小于count的2的幂，
+    // 满时换成两倍容量的新数组，旧数组留在区域中；逐个追加n个元素共复制O(n)个元素。
+    // 因此数组只能是allocateArray<T>(0)或allocateArray<T>(1)的结果，或此后一直由本函数追加得到：
+    // 其他长度(如3)的allocateArray结果没有隐含的余量，追加会越界
+    template <typename T>
+    T* appendToArray(T* items, size_t count, const T& value) {
+        if ((count & (count - 1)) == 0) {
+            T* grown = allocateArray<T>(count == 0 ? 1 : count * 2);
+            copy(items, items + count, grown);
+            items = grown;
+        }
+        items[count] = value;
+        return items;
+    }
+
+    // 保留第一块，丢弃其余内容，便于复用同一区域
+    void reset() {
+        if (blocks.empty()) return;
+        blocks.resize(1);
+        cursor = blocks.front().data.get();
+        limit = cursor + blocks.front().size;
+        bytesUsed = 0;
+    }
+
+    // 接管另一区域的全部块(其中对象的地址不变)，other变为空；之后的分配仍在本区域当前块中进行
+    void absorb(Arena&& other) {
+        for (Block& block : other.blocks) blocks.push_back(move(block));
+        bytesUsed += other.bytesUsed;
+        other.blocks.clear();
+        other.cursor = other.limit = nullptr;
+        other.bytesUsed = 0;
+    }
+
+    size_t bytesAllocated() const { return bytesUsed; }
+    size_t blockCount() const { return blocks.size(); }
+};
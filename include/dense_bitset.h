@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+inline unsigned countTrailingZeros(uint64_t word) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(word));
+#endif
+}
+
+// 定长的稠密位集，用于产生式集合、终结符集合等以稠密ID编号的集合
+class DenseBitset {
+private:
+    vector<uint64_t> words;
+    size_t bits = 0;
+
+public:
+    DenseBitset() = default;
+    explicit DenseBitset(size_t n) : words((n + 63) / 64, 0), bits(n) {}
+
+    size_t size() const { return bits; }
+
+    bool test(size_t i) const { return (words[i >> 6] >> (i & 63)) & 1u; }
+
+    // 置位，返回该位之前是否为0
+    bool set(size_t i) {
+        uint64_t mask = uint64_t(1) << (i & 63);
+        bool wasClear = (words[i >> 6] & mask) == 0;
+        words[i >> 6] |= mask;
+        return wasClear;
+    }
+
+    void reset(size_t i) { words[i >> 6] &= ~(uint64_t(1) << (i & 63)); }
+
+    // 并入另一个同长度的位集，返回是否有新位加入
+    bool unionWith(const DenseBitset& other) {
+        uint64_t added = 0;
+        for (size_t w = 0; w < words.size(); ++w) {
+            uint64_t merged = words[w] | other.words[w];
+            added |= merged ^ words[w];
+            words[w] = merged;
+        }
+        return added != 0;
+    }
+
+    bool any() const {
+        for (uint64_t w : words) {
+            if (w) return true;
+        }
+        return false;
+    }
+
+    bool operator==(const DenseBitset& other) const { return words == other.words; }
+
+    // 按位号从小到大遍历所有置位的位
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (size_t w = 0; w < words.size(); ++w) {
+            uint64_t word = words[w];
+            while (word) {
+                fn(w * 64 + countTrailingZeros(word));
+                word &= word - 1;
+            }
+        }
+    }
+};
@@ -1,16 +1,71 @@
+#pragma once
+
 #include <iostream>
 #include <string>
 #include <vector>
 #include <unordered_map>
 #include <cctype>
+#include <memory>
+#include <cstdint>
+#include <string_view>
+#include "arena.h"
 
 using namespace std;
 
+// 符号种类
+enum SymbolKind {
+    TERMINAL,     // 终结符
+    NONTERMINAL   // 非终结符
+};
+
+// 符号表：在文法加载时把每个符号映射为稠密的整数ID
+// 终结符先编号(0..终结符数-1)，非终结符随后，便于按ID直接索引分析表
+class SymbolTable {
+private:
+    vector<string> names;
+    vector<SymbolKind> kinds;
+    unordered_map<string, int> ids;
+    int terminalCount = 0;
+
+public:
+    // 登记符号，已存在时直接返回原ID
+    int intern(const string& name, SymbolKind kind) {
+        auto it = ids.find(name);
+        if (it != ids.end()) return it->second;
+        int id = static_cast<int>(names.size());
+        names.push_back(name);
+        kinds.push_back(kind);
+        ids.emplace(name, id);
+        if (kind == TERMINAL) terminalCount++;
+        return id;
+    }
+
+    // 查找符号ID，不存在时返回-1
+    int find(const string& name) const {
+        auto it = ids.find(name);
+        return it == ids.end() ? -1 : it->second;
+    }
+
+    const string& name(int id) const { return names[id]; }
+    SymbolKind kind(int id) const { return kinds[id]; }
+    bool isTerminal(int id) const { return kinds[id] == TERMINAL; }
+    bool isNonTerminal(int id) const { return kinds[id] == NONTERMINAL; }
+
+    int size() const { return static_cast<int>(names.size()); }
+    int numTerminals() const { return terminalCount; }
+};
+
 // 文法产生式
 struct Production {
     string left;  // 左部非终结符
     vector<string> right;  // 右部符号串
     int id;  // 产生式编号
+    int lhs = -1;  // 左部符号ID(由SymbolTable分配)
+    vector<int> rhs;  // 右部符号ID串(空产生式"ε"对应空串)
+    bool listAppend = false;  // 列表产生式L -> L X：归约时把X追加为L的子节点，而不是新建一层节点
+
+    Production(const string& l, const vector<string>& r, int i)
+        : left(l), right(r), id(i) {}
 
     bool operator==(const Production& other) const {
         return left == other.left && 
@@ -31,6 +86,28 @@ struct Item {
         return prodId == other.prodId &&
                dotPos == other.dotPos;
     }
+
+    bool operator<(const Item& other) const {
+        return prodId != other.prodId ? prodId < other.prodId : dotPos < other.dotPos;
+    }
+};
+
+// 项集的哈希(要求项集已规范化排序)
+struct ItemSetHash {
+    size_t operator()(const vector<Item>& items) const {
+        size_t h = items.size();
+        for (const auto& item : items) {
+            h ^= hash<long long>()((static_cast<long long>(item.prodId) << 32) | static_cast<unsigned>(item.dotPos))
+                 + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+        }
+        return h;
+    }
+};
+
+// LR(0)项集规范族
+struct CanonicalCollection {
+    vector<vector<Item>> states;                 // 每个状态闭包后的项集
+    vector<vector<pair<int, int>>> transitions;  // 每个状态的转移：(符号ID, 目标状态)
 };
 
 // 语法分析表动作
@@ -46,20 +123,79 @@ struct TableAction {
     int value;  // 移进状态或归约产生式编号
 };
 
-// 语法树节点
+// 语法树节点：全部节点及子节点数组都分配在所属SyntaxTree的Arena中，平凡可析构
 struct SyntaxTreeNode {
-    string symbol;
-    string value;
-    vector<shared_ptr<SyntaxTreeNode>> children;
-    
-    // 添加构造函数
-    SyntaxTreeNode(const string& sym, const string& val) 
-        : symbol(sym), value(val) {}
-    
-    // 默认构造函数
-    SyntaxTreeNode() = default;
-    
-    // 如果需要，添加拷贝和移动构造函数
-    SyntaxTreeNode(const SyntaxTreeNode&) = default;
-    SyntaxTreeNode(SyntaxTreeNode&&) = default;
-};
\ No newline at end of file
+    int32_t symbol;               // 符号ID：叶子为终结符，内部节点为产生式左部
+    uint32_t childCount;
+    uint32_t begin;               // 对应源代码的字节区间[begin, end)
+    uint32_t end;
+    SyntaxTreeNode** children;    // 长度为childCount的连续子节点数组
+};
+
+// 一次分析得到的语法树。持有节点所在的Arena，析构时一次性释放；
+// 同时持有符号表和源代码(及其所有者)，以便按ID取名、按区间取文本
+class SyntaxTree {
+private:
+    Arena arena_;
+    SyntaxTreeNode* root_ = nullptr;
+    shared_ptr<const SymbolTable> symbols_;
+    string_view source_;
+    shared_ptr<const void> sourceOwner_;
+
+public:
+    SyntaxTree() = default;
+    SyntaxTree(Arena arena, SyntaxTreeNode* root, shared_ptr<const SymbolTable> symbols,
+               string_view source, shared_ptr<const void> sourceOwner)
+        : arena_(move(arena)), root_(root), symbols_(move(symbols)),
+          source_(source), sourceOwner_(move(sourceOwner)) {}
+
+    const SyntaxTreeNode* root() const { return root_; }
+    explicit operator bool() const { return root_ != nullptr; }
+
+    const SymbolTable& symbols() const { return *symbols_; }
+    const string& symbolName(const SyntaxTreeNode& node) const { return symbols_->name(node.symbol); }
+    string_view text(const SyntaxTreeNode& node) const { return source_.substr(node.begin, node.end - node.begin); }
+    size_t memoryBytes() const { return arena_.bytesAllocated(); }
+
+    // 把节点所在的Arena并入into并返回可修改的根节点，之后本树为空(用于把多棵树拼接为一棵)
+    SyntaxTreeNode* release(Arena& into) {
+        into.absorb(move(arena_));
+        SyntaxTreeNode* root = root_;
+        root_ = nullptr;
+        return root;
+    }
+};
+
+// 打印语法树：内部节点输出符号名，叶子输出其源代码文本。
+// 用显式栈按先序遍历，树再深也不会耗尽调用栈
+inline void printSyntaxTree(const SyntaxTree& tree, const SyntaxTreeNode* node, int depth = 0) {
+    if (!node) return;
+
+    vector<pair<const SyntaxTreeNode*, int>> pending = {{node, depth}};
+    while (!pending.empty()) {
+        const SyntaxTreeNode* current = pending.back().first;
+        const int level = pending.back().second;
+        pending.pop_back();
+
+        // 缩进
+        for (int i = 0; i < level; ++i) cout << "  ";
+
+        // 节点信息
+        if (tree.symbols().isTerminal(current->symbol)) {
+            string_view text = tree.text(*current);
+            cout << text << " (" << text << ")";
+        } else {
+            cout << tree.symbolName(*current);
+        }
+        cout << endl;
+
+        // 子节点逆序入栈，按原顺序输出
+        for (uint32_t i = current->childCount; i-- > 0;) {
+            pending.push_back({current->children[i], level + 1});
+        }
+    }
+}
+
+inline void printSyntaxTree(const SyntaxTree& tree) {
+    printSyntaxTree(tree, tree.root());
+}
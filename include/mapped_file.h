@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// 只读映射的文件：POSIX下使用mmap(不能映射时从描述符读入)，其他平台退化为一次性读入内存
+class MappedFile {
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    vector<char> buffer_;  // 未能映射时的后备存储
+
+    MappedFile() = default;
+
+public:
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+#ifndef _WIN32
+        if (mapped_) munmap(const_cast<char*>(data_), size_);
+#endif
+    }
+
+    static shared_ptr<MappedFile> open(const string& path) {
+        shared_ptr<MappedFile> file(new MappedFile());
+#ifndef _WIN32
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw runtime_error("Failed to open file " + path);
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            void* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                file->data_ = static_cast<const char*>(addr);
+                file->size_ = static_cast<size_t>(st.st_size);
+                file->mapped_ = true;
+                madvise(addr, file->size_, MADV_SEQUENTIAL);  // 词法分析顺序读取，提示内核预读
+            }
+        }
+        if (!file->mapped_) {
+            // 管道、FIFO等不能映射也可能只能读一次，在已打开的描述符上读入，不按路径重新打开
+            char chunk[1 << 16];
+            for (;;) {
+                ssize_t n = ::read(fd, chunk, sizeof(chunk));
+                if (n > 0) {
+                    file->buffer_.insert(file->buffer_.end(), chunk, chunk + n);
+                } else if (n == 0) {
+                    break;
+                } else if (errno != EINTR) {
+                    ::close(fd);
+                    throw runtime_error("Failed to read file " + path);
+                }
+            }
+            file->data_ = file->buffer_.data();
+            file->size_ = file->buffer_.size();
+        }
+        ::close(fd);
+#else
+        ifstream in(path, ios::binary);
+        if (!in.is_open()) {
+            throw runtime_error("Failed to open file " + path);
+        }
+        file->buffer_.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+        file->data_ = file->buffer_.data();
+        file->size_ = file->buffer_.size();
+#endif
+        return file;
+    }
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool isMapped() const { return mapped_; }
+};
@@ -0,0 +1,378 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <vector>
+#include "grammer.h"
+
+using namespace std;
+
+// 按缓存行(64字节)对齐分配内存，保证分析表每一行都从缓存行起始处开始
+template <typename T>
+struct CacheAlignedAllocator {
+    using value_type = T;
+    static constexpr size_t kAlignment = 64;
+
+    CacheAlignedAllocator() = default;
+    template <typename U>
+    CacheAlignedAllocator(const CacheAlignedAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), align_val_t(kAlignment)));
+    }
+
+    void deallocate(T* p, size_t) {
+        ::operator delete(p, align_val_t(kAlignment));
+    }
+
+    template <typename U>
+    bool operator==(const CacheAlignedAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const CacheAlignedAllocator<U>&) const { return false; }
+};
+
+// 压缩编码的ACTION表项：低2位为动作类别，高30位为目标(移进状态或归约产生式编号)
+// 全0表示ERROR，因此新分配的表默认全部是出错项
+using PackedAction = uint32_t;
+
+enum : uint32_t {
+    PACKED_ERROR = 0,
+    PACKED_SHIFT = 1,
+    PACKED_REDUCE = 2,
+    PACKED_ACCEPT = 3
+};
+
+inline PackedAction packAction(ActionType type, int value) {
+    switch (type) {
+        case SHIFT:  return (static_cast<uint32_t>(value) << 2) | PACKED_SHIFT;
+        case REDUCE: return (static_cast<uint32_t>(value) << 2) | PACKED_REDUCE;
+        case ACCEPT: return PACKED_ACCEPT;
+        default:     return PACKED_ERROR;
+    }
+}
+
+inline TableAction unpackAction(PackedAction entry) {
+    switch (entry & 3u) {
+        case PACKED_SHIFT:  return {SHIFT, static_cast<int>(entry >> 2)};
+        case PACKED_REDUCE: return {REDUCE, static_cast<int>(entry >> 2)};
+        case PACKED_ACCEPT: return {ACCEPT, -1};
+        default:            return {ERROR, -1};
+    }
+}
+
+// 稠密的二维ACTION/GOTO分析表：状态数 × 终结符数 / 状态数 × 非终结符数
+// 行宽按缓存行补齐，一次查表就是一次下标访问
+// 表数据既可以由本对象自己持有(运行时构造)，也可以直接引用外部内存(如mmap映射的表文件)
+struct ParseTable {
+    static constexpr size_t kRowAlignment = CacheAlignedAllocator<PackedAction>::kAlignment / sizeof(PackedAction);
+
+    int numStates = 0;
+    int numTerminals = 0;      // 终结符ID范围 [0, numTerminals)
+    int numNonTerminals = 0;   // 非终结符ID范围 [numTerminals, numTerminals + numNonTerminals)
+    size_t actionStride = 0;   // ACTION表每行的元素数(含补齐)
+    size_t gotoStride = 0;     // GOTO表每行的元素数(含补齐)
+
+    ParseTable() = default;
+    ParseTable(const ParseTable& other) { *this = other; }
+    ParseTable(ParseTable&& other) noexcept { *this = move(other); }
+
+    ParseTable& operator=(const ParseTable& other) {
+        copyShape(other);
+        actions = other.actions;
+        gotos = other.gotos;
+        backing = other.backing;
+        rebind(other);
+        return *this;
+    }
+
+    ParseTable& operator=(ParseTable&& other) noexcept {
+        copyShape(other);
+        actions = move(other.actions);
+        gotos = move(other.gotos);
+        backing = move(other.backing);
+        rebind(other);
+        return *this;
+    }
+
+    // 分配自有存储，所有表项初始化为ERROR/无转移
+    void resize(int states, int terminals, int nonTerminals) {
+        numStates = states;
+        numTerminals = terminals;
+        numNonTerminals = nonTerminals;
+        actionStride = roundUp(static_cast<size_t>(terminals));
+        gotoStride = roundUp(static_cast<size_t>(nonTerminals));
+        actions.assign(static_cast<size_t>(states) * actionStride, PACKED_ERROR);
+        gotos.assign(static_cast<size_t>(states) * gotoStride, -1);
+        backing.reset();
+        actionData = actions.data();
+        gotoData = gotos.data();
+    }
+
+    // 直接引用外部内存中的表数据(不复制)；owner负责让这块内存在表的生命周期内保持有效
+    void attach(shared_ptr<const void> owner, const PackedAction* actionTable, const int32_t* gotoTable,
+                int states, int terminals, int nonTerminals, size_t actionRowStride, size_t gotoRowStride) {
+        actions.clear();
+        gotos.clear();
+        backing = move(owner);
+        numStates = states;
+        numTerminals = terminals;
+        numNonTerminals = nonTerminals;
+        actionStride = actionRowStride;
+        gotoStride = gotoRowStride;
+        actionData = actionTable;
+        gotoData = gotoTable;
+    }
+
+    PackedAction action(int state, int terminal) const {
+        return actionData[static_cast<size_t>(state) * actionStride + terminal];
+    }
+
+    void setAction(int state, int terminal, PackedAction entry) {
+        actions[static_cast<size_t>(state) * actionStride + terminal] = entry;
+    }
+
+    // nonTerminal为符号ID，返回-1表示没有GOTO转移
+    int gotoState(int state, int nonTerminal) const {
+        return gotoData[static_cast<size_t>(state) * gotoStride + (nonTerminal - numTerminals)];
+    }
+
+    void setGoto(int state, int nonTerminal, int target) {
+        gotos[static_cast<size_t>(state) * gotoStride + (nonTerminal - numTerminals)] = target;
+    }
+
+    // 原始行数据，供序列化使用
+    const PackedAction* actionRows() const { return actionData; }
+    const int32_t* gotoRows() const { return gotoData; }
+
+    size_t memoryBytes() const {
+        return static_cast<size_t>(numStates) * (actionStride * sizeof(PackedAction) + gotoStride * sizeof(int32_t));
+    }
+
+private:
+    vector<PackedAction, CacheAlignedAllocator<PackedAction>> actions;
+    vector<int32_t, CacheAlignedAllocator<int32_t>> gotos;  // -1表示无转移
+    shared_ptr<const void> backing;  // 外部表数据的持有者
+    const PackedAction* actionData = nullptr;
+    const int32_t* gotoData = nullptr;
+
+    static size_t roundUp(size_t n) {
+        return (n + kRowAlignment - 1) / kRowAlignment * kRowAlignment;
+    }
+
+    void copyShape(const ParseTable& other) {
+        numStates = other.numStates;
+        numTerminals = other.numTerminals;
+        numNonTerminals = other.numNonTerminals;
+        actionStride = other.actionStride;
+        gotoStride = other.gotoStride;
+    }
+
+    // 自有存储时指向自己的数组，否则沿用对方引用的外部内存
+    void rebind(const ParseTable& other) {
+        actionData = backing || actions.empty() ? other.actionData : actions.data();
+        gotoData = backing || gotos.empty() ? other.gotoData : gotos.data();
+    }
+};
+
+// 分析器运行所需的全部数据：符号表、(已翻译为ID的)产生式和分析表
+struct GrammarTables {
+    SymbolTable symbols;
+    vector<Production> productions;
+    ParseTable table;
+};
+
+// 分析表的存储格式
+enum TableFormat {
+    DENSE_TABLE,       // 稠密二维表
+    COMPRESSED_TABLE   // 行位移压缩表
+};
+
+// 压缩的分析表(行位移/梳状向量)
+// ACTION：每个状态把出现次数最多的归约作为缺省动作，其余表项按行位移放入共享的next/check向量；
+//         内容完全相同的行合并为同一行号，只存一份
+// GOTO：按非终结符列压缩，每列以出现次数最多的目标状态作为缺省值
+// 缺省值只填补原本有动作/转移的表项：每行另存出错位图、每列另存有转移位图，
+// 查表结果与稠密表逐项相同，出错检测的位置和错误恢复的行为也因此与稠密表一致
+struct CompressedParseTable {
+    int numStates = 0;
+    int numTerminals = 0;
+    int numNonTerminals = 0;
+
+    vector<int32_t> rowOf;             // 状态 -> 合并后的行号
+    vector<PackedAction> rowDefault;   // 行号 -> 缺省动作
+    vector<int32_t> rowBase;           // 行号 -> 在next/check中的位移
+    vector<PackedAction> actionNext;
+    vector<int32_t> actionCheck;       // 槽位所属的行号，-1表示空闲
+    vector<uint32_t> rowErrors;        // 行号 -> 出错终结符位图，每行errorWords()个字
+
+    vector<int32_t> gotoDefault;       // 非终结符列 -> 缺省目标状态
+    vector<int32_t> gotoBase;          // 非终结符列 -> 位移
+    vector<int32_t> gotoNext;
+    vector<int32_t> gotoCheck;         // 槽位所属的列号，-1表示空闲
+    vector<uint32_t> gotoPresent;      // 非终结符列 -> 有转移的状态位图，每列presentWords()个字
+
+    size_t errorWords() const { return (static_cast<size_t>(numTerminals) + 31) / 32; }
+    size_t presentWords() const { return (static_cast<size_t>(numStates) + 31) / 32; }
+
+    PackedAction action(int state, int terminal) const {
+        const int32_t row = rowOf[state];
+        const size_t i = static_cast<size_t>(rowBase[row]) + terminal;
+        if (actionCheck[i] == row) return actionNext[i];
+        const uint32_t word = rowErrors[static_cast<size_t>(row) * errorWords() + terminal / 32];
+        return (word >> (terminal % 32)) & 1u ? PACKED_ERROR : rowDefault[row];
+    }
+
+    // nonTerminal为符号ID，返回-1表示没有GOTO转移
+    int gotoState(int state, int nonTerminal) const {
+        const int column = nonTerminal - numTerminals;
+        const size_t i = static_cast<size_t>(gotoBase[column]) + state;
+        if (gotoCheck[i] == column) return gotoNext[i];
+        const uint32_t word = gotoPresent[static_cast<size_t>(column) * presentWords() + state / 32];
+        return (word >> (state % 32)) & 1u ? gotoDefault[column] : -1;
+    }
+
+    // 压缩后实际占用的字节数
+    size_t memoryBytes() const {
+        return sizeof(int32_t) * (rowOf.size() + rowBase.size() + actionCheck.size() +
+                                  gotoDefault.size() + gotoBase.size() + gotoNext.size() + gotoCheck.size()) +
+               sizeof(PackedAction) * (rowDefault.size() + actionNext.size()) +
+               sizeof(uint32_t) * (rowErrors.size() + gotoPresent.size());
+    }
+
+    static CompressedParseTable compress(const ParseTable& dense) {
+        CompressedParseTable table;
+        table.numStates = dense.numStates;
+        table.numTerminals = dense.numTerminals;
+        table.numNonTerminals = dense.numNonTerminals;
+
+        // 1. 计算每行的缺省归约，并把剩余的显式表项整理成稀疏行，出错表项记入位图
+        vector<vector<pair<int, PackedAction>>> rows;
+        vector<PackedAction> defaults;
+        map<tuple<PackedAction, vector<pair<int, PackedAction>>, vector<uint32_t>>, int32_t> rowIndex;
+        table.rowOf.resize(dense.numStates);
+        for (int state = 0; state < dense.numStates; ++state) {
+            map<PackedAction, int> reduceCount;
+            for (int t = 0; t < dense.numTerminals; ++t) {
+                PackedAction entry = dense.action(state, t);
+                if ((entry & 3u) == PACKED_REDUCE) reduceCount[entry]++;
+            }
+            PackedAction def = PACKED_ERROR;
+            int best = 0;
+            for (const auto& kv : reduceCount) {
+                if (kv.second > best) {
+                    best = kv.second;
+                    def = kv.first;
+                }
+            }
+
+            vector<pair<int, PackedAction>> row;
+            vector<uint32_t> errors(table.errorWords(), 0);
+            for (int t = 0; t < dense.numTerminals; ++t) {
+                PackedAction entry = dense.action(state, t);
+                if (entry == PACKED_ERROR) {
+                    errors[t / 32] |= 1u << (t % 32);
+                } else if (entry != def) {
+                    row.emplace_back(t, entry);
+                }
+            }
+
+            // 2. 合并完全相同的行
+            auto key = make_tuple(def, row, errors);
+            auto it = rowIndex.find(key);
+            if (it == rowIndex.end()) {
+                it = rowIndex.emplace(key, static_cast<int32_t>(rows.size())).first;
+                rows.push_back(move(row));
+                defaults.push_back(def);
+                table.rowErrors.insert(table.rowErrors.end(), errors.begin(), errors.end());
+            }
+            table.rowOf[state] = it->second;
+        }
+        table.rowDefault = defaults;
+        table.rowBase = packRows(rows, dense.numTerminals, table.actionNext, table.actionCheck);
+
+        // 3. GOTO按列压缩
+        vector<vector<pair<int, int32_t>>> columns(dense.numNonTerminals);
+        table.gotoDefault.assign(dense.numNonTerminals, -1);
+        table.gotoPresent.assign(static_cast<size_t>(dense.numNonTerminals) * table.presentWords(), 0);
+        for (int column = 0; column < dense.numNonTerminals; ++column) {
+            const int nonTerminal = dense.numTerminals + column;
+            map<int32_t, int> targetCount;
+            for (int state = 0; state < dense.numStates; ++state) {
+                int target = dense.gotoState(state, nonTerminal);
+                if (target == -1) continue;
+                targetCount[target]++;
+                table.gotoPresent[static_cast<size_t>(column) * table.presentWords() + state / 32] |= 1u << (state % 32);
+            }
+            int best = 0;
+            for (const auto& kv : targetCount) {
+                if (kv.second > best) {
+                    best = kv.second;
+                    table.gotoDefault[column] = kv.first;
+                }
+            }
+            for (int state = 0; state < dense.numStates; ++state) {
+                int target = dense.gotoState(state, nonTerminal);
+                if (target != -1 && target != table.gotoDefault[column]) {
+                    columns[column].emplace_back(state, target);
+                }
+            }
+        }
+        table.gotoBase = packRows(columns, dense.numStates, table.gotoNext, table.gotoCheck);
+        return table;
+    }
+
+private:
+    // 首次适应的行位移：表项多的行先放，为每行寻找不与已占用槽位冲突的最小位移
+    // 向量末尾补齐width个槽位，保证任意 位移+列号 的访问都不越界
+    template <typename T>
+    static vector<int32_t> packRows(const vector<vector<pair<int, T>>>& rows, int width,
+                                    vector<T>& next, vector<int32_t>& check) {
+        vector<int32_t> base(rows.size(), 0);
+        vector<size_t> order(rows.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        stable_sort(order.begin(), order.end(), [&rows](size_t a, size_t b) {
+            return rows[a].size() > rows[b].size();
+        });
+
+        next.clear();
+        check.clear();
+        size_t used = 0;
+        for (size_t r : order) {
+            const auto& row = rows[r];
+            size_t offset = 0;
+            for (;; ++offset) {
+                bool fits = true;
+                for (const auto& entry : row) {
+                    size_t slot = offset + entry.first;
+                    if (slot < check.size() && check[slot] != -1) {
+                        fits = false;
+                        break;
+                    }
+                }
+                if (fits) break;
+            }
+            if (check.size() < offset + width) {
+                check.resize(offset + width, -1);
+                next.resize(offset + width, T{});
+            }
+            for (const auto& entry : row) {
+                check[offset + entry.first] = static_cast<int32_t>(r);
+                next[offset + entry.first] = entry.second;
+                used = max(used, offset + entry.first + 1);
+            }
+            base[r] = static_cast<int32_t>(offset);
+        }
+
+        // 去掉末尾多余的空槽，只保留最大位移处一整行的宽度
+        size_t needed = used;
+        for (int32_t b : base) needed = max(needed, static_cast<size_t>(b) + width);
+        check.resize(needed, -1);
+        next.resize(needed, T{});
+        return base;
+    }
+};
@@ -0,0 +1,308 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "dense_bitset.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SLR_SCAN_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// AVX2内核只在GCC/Clang下以target属性单独编译，运行时检测CPU后才会调用
+#if defined(SLR_SCAN_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SLR_SCAN_AVX2 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+inline unsigned popCount(uint64_t word) {
+#ifdef _MSC_VER
+    return static_cast<unsigned>(__popcnt64(word));
+#else
+    return static_cast<unsigned>(__builtin_popcountll(word));
+#endif
+}
+
+// 词法分析中的批量扫描操作。每个函数在[p, end)内扫描，返回第一个不满足条件的位置(找不到时返回end)
+struct ScanKernels {
+    const char* name;
+    const char* (*skipWhitespace)(const char* p, const char* end, size_t& newlines);  // 空白，同时统计换行
+    const char* (*skipIdentifier)(const char* p, const char* end);                    // [A-Za-z0-9_]
+    const char* (*skipDigits)(const char* p, const char* end);                        // [0-9]
+    const char* (*findNewline)(const char* p, const char* end);                       // 下一个'\n'
+    const char* (*findCommentEnd)(const char* p, const char* end);                    // 下一个"*/"的'*'
+    size_t (*countNewlines)(const char* p, const char* end);
+};
+
+// ---------------- 标量实现 ----------------
+
+namespace scalar_scan {
+
+inline bool isSpace(unsigned char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+inline bool isDigit(unsigned char c) { return c >= '0' && c <= '9'; }
+inline bool isIdentifier(unsigned char c) {
+    return isDigit(c) || c == '_' || static_cast<unsigned char>((c | 0x20) - 'a') < 26;
+}
+
+inline const char* skipWhitespace(const char* p, const char* end, size_t& newlines) {
+    for (; p < end && isSpace(static_cast<unsigned char>(*p)); ++p) {
+        newlines += *p == '\n';
+    }
+    return p;
+}
+
+inline const char* skipIdentifier(const char* p, const char* end) {
+    while (p < end && isIdentifier(static_cast<unsigned char>(*p))) ++p;
+    return p;
+}
+
+inline const char* skipDigits(const char* p, const char* end) {
+    while (p < end && isDigit(static_cast<unsigned char>(*p))) ++p;
+    return p;
+}
+
+inline const char* findNewline(const char* p, const char* end) {
+    while (p < end && *p != '\n') ++p;
+    return p;
+}
+
+inline const char* findCommentEnd(const char* p, const char* end) {
+    for (; p + 1 < end; ++p) {
+        if (p[0] == '*' && p[1] == '/') return p;
+    }
+    return end;
+}
+
+inline size_t countNewlines(const char* p, const char* end) {
+    size_t count = 0;
+    for (; p < end; ++p) count += *p == '\n';
+    return count;
+}
+
+} // namespace scalar_scan
+
+inline const ScanKernels& scalarScanKernels() {
+    static const ScanKernels kernels = {
+        "scalar",
+        scalar_scan::skipWhitespace, scalar_scan::skipIdentifier, scalar_scan::skipDigits,
+        scalar_scan::findNewline, scalar_scan::findCommentEnd, scalar_scan::countNewlines
+    };
+    return kernels;
+}
+
+// ---------------- SSE2实现(16字节) ----------------
+
+#ifdef SLR_SCAN_SSE2
+namespace sse2_scan {
+
+// 无符号区间[lo, hi]的逐字节判断：平移后做有符号比较
+inline __m128i inRange(__m128i v, char lo, char hi) {
+    const __m128i shifted = _mm_add_epi8(v, _mm_set1_epi8(static_cast<char>(0x80 - static_cast<unsigned char>(lo))));
+    return _mm_cmplt_epi8(shifted, _mm_set1_epi8(static_cast<char>(0x80 + (hi - lo) + 1)));
+}
+
+inline __m128i spaceMask(__m128i v) {
+    return _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), inRange(v, '\t', '\r'));
+}
+
+inline __m128i digitMask(__m128i v) { return inRange(v, '0', '9'); }
+
+inline __m128i identifierMask(__m128i v) {
+    const __m128i letter = inRange(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z');
+    return _mm_or_si128(_mm_or_si128(letter, digitMask(v)), _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+}
+
+inline unsigned bits(__m128i mask) { return static_cast<unsigned>(_mm_movemask_epi8(mask)); }
+
+inline const char* skipWhitespace(const char* p, const char* end, size_t& newlines) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; p + 16 <= end; p += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const unsigned stop = ~bits(spaceMask(v)) & 0xFFFFu;
+        const unsigned lines = bits(_mm_cmpeq_epi8(v, newline));
+        if (stop) {
+            const unsigned n = countTrailingZeros(stop);
+            newlines += popCount(lines & ((1u << n) - 1));
+            return p + n;
+        }
+        newlines += popCount(lines);
+    }
+    return scalar_scan::skipWhitespace(p, end, newlines);
+}
+
+template <__m128i (*Mask)(__m128i), const char* (*Tail)(const char*, const char*)>
+inline const char* skipWhile(const char* p, const char* end) {
+    for (; p + 16 <= end; p += 16) {
+        const unsigned stop = ~bits(Mask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)))) & 0xFFFFu;
+        if (stop) return p + countTrailingZeros(stop);
+    }
+    return Tail(p, end);
+}
+
+inline const char* skipIdentifier(const char* p, const char* end) {
+    return skipWhile<identifierMask, scalar_scan::skipIdentifier>(p, end);
+}
+
+inline const char* skipDigits(const char* p, const char* end) {
+    return skipWhile<digitMask, scalar_scan::skipDigits>(p, end);
+}
+
+inline const char* findNewline(const char* p, const char* end) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; p + 16 <= end; p += 16) {
+        const unsigned hit = bits(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), newline));
+        if (hit) return p + countTrailingZeros(hit);
+    }
+    return scalar_scan::findNewline(p, end);
+}
+
+inline const char* findCommentEnd(const char* p, const char* end) {
+    const __m128i star = _mm_set1_epi8('*');
+    const __m128i slash = _mm_set1_epi8('/');
+    // 同时比较p[i]=='*'与p[i+1]=='/'，需要多读1字节
+    for (; p + 17 <= end; p += 16) {
+        const __m128i first = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), star);
+        const __m128i second = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1)), slash);
+        const unsigned hit = bits(_mm_and_si128(first, second));
+        if (hit) return p + countTrailingZeros(hit);
+    }
+    return scalar_scan::findCommentEnd(p, end);
+}
+
+inline size_t countNewlines(const char* p, const char* end) {
+    const __m128i newline = _mm_set1_epi8('\n');
+    size_t count = 0;
+    for (; p + 16 <= end; p += 16) {
+        count += popCount(bits(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), newline)));
+    }
+    return count + scalar_scan::countNewlines(p, end);
+}
+
+} // namespace sse2_scan
+
+inline const ScanKernels& sse2ScanKernels() {
+    static const ScanKernels kernels = {
+        "sse2",
+        sse2_scan::skipWhitespace, sse2_scan::skipIdentifier, sse2_scan::skipDigits,
+        sse2_scan::findNewline, sse2_scan::findCommentEnd, sse2_scan::countNewlines
+    };
+    return kernels;
+}
+#endif
+
+// ---------------- AVX2实现(32字节) ----------------
+
+#ifdef SLR_SCAN_AVX2
+#define SLR_AVX2_FN __attribute__((target("avx2"))) inline
+
+namespace avx2_scan {
+
+SLR_AVX2_FN __m256i load(const char* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+
+SLR_AVX2_FN __m256i inRange(__m256i v, char lo, char hi) {
+    const __m256i shifted = _mm256_add_epi8(v, _mm256_set1_epi8(static_cast<char>(0x80 - static_cast<unsigned char>(lo))));
+    return _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(0x80 + (hi - lo) + 1)), shifted);
+}
+
+SLR_AVX2_FN uint32_t bits(__m256i mask) { return static_cast<uint32_t>(_mm256_movemask_epi8(mask)); }
+
+SLR_AVX2_FN uint32_t spaceBits(__m256i v) {
+    return bits(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), inRange(v, '\t', '\r')));
+}
+
+SLR_AVX2_FN uint32_t digitBits(__m256i v) { return bits(inRange(v, '0', '9')); }
+
+SLR_AVX2_FN uint32_t identifierBits(__m256i v) {
+    const __m256i letter = inRange(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z');
+    return bits(_mm256_or_si256(_mm256_or_si256(letter, inRange(v, '0', '9')),
+                                _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'))));
+}
+
+SLR_AVX2_FN uint32_t newlineBits(__m256i v) { return bits(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'))); }
+
+SLR_AVX2_FN const char* skipWhitespace(const char* p, const char* end, size_t& newlines) {
+    for (; p + 32 <= end; p += 32) {
+        const __m256i v = load(p);
+        const uint32_t stop = ~spaceBits(v);
+        const uint32_t lines = newlineBits(v);
+        if (stop) {
+            const unsigned n = countTrailingZeros(stop);
+            newlines += popCount(lines & ((uint64_t(1) << n) - 1));
+            return p + n;
+        }
+        newlines += popCount(lines);
+    }
+    return sse2_scan::skipWhitespace(p, end, newlines);
+}
+
+SLR_AVX2_FN const char* skipIdentifier(const char* p, const char* end) {
+    for (; p + 32 <= end; p += 32) {
+        const uint32_t stop = ~identifierBits(load(p));
+        if (stop) return p + countTrailingZeros(stop);
+    }
+    return sse2_scan::skipIdentifier(p, end);
+}
+
+SLR_AVX2_FN const char* skipDigits(const char* p, const char* end) {
+    for (; p + 32 <= end; p += 32) {
+        const uint32_t stop = ~digitBits(load(p));
+        if (stop) return p + countTrailingZeros(stop);
+    }
+    return sse2_scan::skipDigits(p, end);
+}
+
+SLR_AVX2_FN const char* findNewline(const char* p, const char* end) {
+    for (; p + 32 <= end; p += 32) {
+        const uint32_t hit = newlineBits(load(p));
+        if (hit) return p + countTrailingZeros(hit);
+    }
+    return sse2_scan::findNewline(p, end);
+}
+
+SLR_AVX2_FN const char* findCommentEnd(const char* p, const char* end) {
+    for (; p + 33 <= end; p += 32) {
+        const __m256i first = _mm256_cmpeq_epi8(load(p), _mm256_set1_epi8('*'));
+        const __m256i second = _mm256_cmpeq_epi8(load(p + 1), _mm256_set1_epi8('/'));
+        const uint32_t hit = bits(_mm256_and_si256(first, second));
+        if (hit) return p + countTrailingZeros(hit);
+    }
+    return sse2_scan::findCommentEnd(p, end);
+}
+
+SLR_AVX2_FN size_t countNewlines(const char* p, const char* end) {
+    size_t count = 0;
+    for (; p + 32 <= end; p += 32) count += popCount(newlineBits(load(p)));
+    return count + sse2_scan::countNewlines(p, end);
+}
+
+} // namespace avx2_scan
+
+#undef SLR_AVX2_FN
+
+inline const ScanKernels& avx2ScanKernels() {
+    static const ScanKernels kernels = {
+        "avx2",
+        avx2_scan::skipWhitespace, avx2_scan::skipIdentifier, avx2_scan::skipDigits,
+        avx2_scan::findNewline, avx2_scan::findCommentEnd, avx2_scan::countNewlines
+    };
+    return kernels;
+}
+#endif
+
+// 按运行时CPU特性选择最快的实现，首次调用时检测一次
+inline const ScanKernels& scanKernels() {
+    static const ScanKernels& selected = []() -> const ScanKernels& {
+#ifdef SLR_SCAN_AVX2
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return avx2ScanKernels();
+#endif
+#ifdef SLR_SCAN_SSE2
+        return sse2ScanKernels();
+#else
+        return scalarScanKernels();
+#endif
+    }();
+    return selected;
+}
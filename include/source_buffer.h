@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "mapped_file.h"
+
+using namespace std;
+
+// 词法分析的输入缓冲区。普通文件直接映射，Token中的string_view指向映射区域而不做复制；
+// 管道和标准输入无法映射，退化为一次性读入
+class SourceBuffer {
+private:
+    string name_;
+    shared_ptr<MappedFile> file_;
+    string owned_;
+    string_view text_;
+
+    explicit SourceBuffer(string name) : name_(move(name)) {}
+
+public:
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+    // 打开源文件，路径为"-"时读取标准输入
+    static shared_ptr<const SourceBuffer> open(const string& path) {
+        if (path == "-") {
+            return readStream(stdin, "<stdin>");
+        }
+        shared_ptr<SourceBuffer> buffer(new SourceBuffer(path));
+        buffer->file_ = MappedFile::open(path);
+        buffer->text_ = string_view(buffer->file_->data(), buffer->file_->size());
+        return buffer;
+    }
+
+    // 从流中读入全部内容(用于管道等不可映射的输入)
+    static shared_ptr<const SourceBuffer> readStream(FILE* stream, const string& name) {
+        shared_ptr<SourceBuffer> buffer(new SourceBuffer(name));
+        char chunk[1 << 16];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), stream)) > 0) {
+            buffer->owned_.append(chunk, n);
+        }
+        if (ferror(stream)) {
+            throw runtime_error("Failed to read " + name);
+        }
+        buffer->text_ = buffer->owned_;
+        return buffer;
+    }
+
+    // 持有一段内存中的源代码
+    static shared_ptr<const SourceBuffer> fromString(string text, const string& name = "<string>") {
+        shared_ptr<SourceBuffer> buffer(new SourceBuffer(name));
+        buffer->owned_ = move(text);
+        buffer->text_ = buffer->owned_;
+        return buffer;
+    }
+
+    string_view text() const { return text_; }
+    const string& name() const { return name_; }
+    bool isMapped() const { return file_ && file_->isMapped(); }
+};
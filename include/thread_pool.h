@@ -0,0 +1,149 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// 工作窃取线程池：每个工作线程有自己的任务队列，从队尾取自己的任务，
+// 队列为空时从其他线程的队首窃取，任务耗时不均时各线程仍能保持忙碌
+class ThreadPool {
+private:
+    struct WorkQueue {
+        mutex lock;
+        deque<function<void()>> tasks;
+    };
+
+    vector<unique_ptr<WorkQueue>> queues_;
+    vector<thread> threads_;
+
+    mutex stateLock_;
+    condition_variable workAvailable_;
+    condition_variable allDone_;
+    atomic<size_t> queued_{0};    // 已提交但尚未被取走的任务数
+    atomic<size_t> pending_{0};   // 已提交但尚未执行完的任务数
+    atomic<size_t> nextQueue_{0};
+    bool stopping_ = false;
+
+    // 当前线程所属的线程池及其中的工作线程编号
+    struct WorkerSlot {
+        const ThreadPool* pool = nullptr;
+        size_t index = 0;
+    };
+
+    static WorkerSlot& currentWorker() {
+        static thread_local WorkerSlot slot;
+        return slot;
+    }
+
+    bool popLocal(size_t i, function<void()>& task) {
+        WorkQueue& queue = *queues_[i];
+        lock_guard<mutex> guard(queue.lock);
+        if (queue.tasks.empty()) return false;
+        task = move(queue.tasks.back());
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(size_t thief, function<void()>& task) {
+        for (size_t k = 1; k < queues_.size(); ++k) {
+            WorkQueue& queue = *queues_[(thief + k) % queues_.size()];
+            lock_guard<mutex> guard(queue.lock);
+            if (queue.tasks.empty()) continue;
+            task = move(queue.tasks.front());
+            queue.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+    void run(size_t i) {
+        currentWorker() = {this, i};
+        function<void()> task;
+        for (;;) {
+            if (popLocal(i, task) || steal(i, task)) {
+                queued_.fetch_sub(1);
+                task();
+                task = nullptr;
+                if (pending_.fetch_sub(1) == 1) {
+                    lock_guard<mutex> guard(stateLock_);
+                    allDone_.notify_all();
+                }
+                continue;
+            }
+            unique_lock<mutex> lock(stateLock_);
+            workAvailable_.wait(lock, [this] { return stopping_ || queued_.load() > 0; });
+            if (stopping_ && queued_.load() == 0) return;
+        }
+    }
+
+public:
+    explicit ThreadPool(size_t threadCount = thread::hardware_concurrency()) {
+        if (threadCount == 0) threadCount = 1;
+        for (size_t i = 0; i < threadCount; ++i) queues_.push_back(make_unique<WorkQueue>());
+        for (size_t i = 0; i < threadCount; ++i) threads_.emplace_back([this, i] { run(i); });
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> guard(stateLock_);
+            stopping_ = true;
+        }
+        workAvailable_.notify_all();
+        for (thread& t : threads_) t.join();
+    }
+
+    size_t size() const { return threads_.size(); }
+
+    // 提交任务(任务不得抛出异常)：工作线程内提交的任务进入自己的队列，外部提交的任务轮流分配
+    void submit(function<void()> task) {
+        const WorkerSlot& self = currentWorker();
+        size_t i = self.pool == this ? self.index : nextQueue_.fetch_add(1) % queues_.size();
+        pending_.fetch_add(1);
+        {
+            // 先计数再入队，计数始终不小于队列中的任务数
+            lock_guard<mutex> guard(stateLock_);
+            queued_.fetch_add(1);
+        }
+        {
+            lock_guard<mutex> guard(queues_[i]->lock);
+            queues_[i]->tasks.push_back(move(task));
+        }
+        workAvailable_.notify_one();
+    }
+
+    // 等待所有已提交的任务执行完毕(不能在任务内部调用)
+    void wait() {
+        unique_lock<mutex> lock(stateLock_);
+        allDone_.wait(lock, [this] { return pending_.load() == 0; });
+    }
+};
+
+// 把[0, count)分块交给线程池执行fn(i)并等待全部完成(不能在线程池任务内部调用)。
+// pool为空或count不足一块时直接在当前线程顺序执行
+template <typename Fn>
+inline void parallelFor(ThreadPool* pool, size_t count, const Fn& fn, size_t minChunk = 16) {
+    if (pool == nullptr || pool->size() <= 1 || count <= minChunk) {
+        for (size_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+    // 块数取线程数的数倍，耗时不均时由工作窃取平衡负载
+    const size_t chunk = max(minChunk, (count + pool->size() * 4 - 1) / (pool->size() * 4));
+    for (size_t begin = 0; begin < count; begin += chunk) {
+        const size_t end = min(count, begin + chunk);
+        pool->submit([&fn, begin, end] {
+            for (size_t i = begin; i < end; ++i) fn(i);
+        });
+    }
+    pool->wait();
+}
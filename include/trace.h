@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string_view>
+
+using namespace std;
+
+// 跟踪输出级别，数值越大越详细
+enum TraceLevel {
+    TRACE_OFF = 0,
+    TRACE_ERROR = 1,    // 语法错误等诊断信息
+    TRACE_INFO = 2,     // 每次分析/建表一两行的概要
+    TRACE_DEBUG = 3,    // FIRST/FOLLOW集等中间结果
+    TRACE_VERBOSE = 4   // 每个Token、每次移进/归约、每个新状态
+};
+
+// 编译期允许的最高级别：高于它的跟踪语句连同参数求值一起被编译掉。
+// 默认只保留错误诊断，CMake选项SLR_TRACE=ON时定义为TRACE_VERBOSE
+#ifndef SLR_TRACE
+#define SLR_TRACE 1
+#endif
+
+// 跟踪输出的接收者，由调用者提供；默认写到cerr(不刷新)
+using TraceSink = function<void(TraceLevel, string_view)>;
+
+struct TraceConfig {
+    atomic<int> level{TRACE_ERROR};
+    TraceSink sink = [](TraceLevel, string_view message) { cerr << message << '\n'; };
+};
+
+inline TraceConfig& traceConfig() {
+    static TraceConfig config;
+    return config;
+}
+
+// 运行期级别只能在编译期允许的范围内生效
+inline void setTraceLevel(TraceLevel level) { traceConfig().level.store(level, memory_order_relaxed); }
+
+// 应在开始分析前设置，分析过程中不可更换
+inline void setTraceSink(TraceSink sink) { traceConfig().sink = move(sink); }
+
+inline bool traceEnabled(TraceLevel level) {
+    return SLR_TRACE >= level && traceConfig().level.load(memory_order_relaxed) >= level;
+}
+
+inline void traceWrite(TraceLevel level, string_view message) {
+    traceConfig().sink(level, message);
+}
+
+// 把序列格式化为以空格分隔的文本，用于在跟踪语句中输出栈等内容
+template <typename Range, typename Format>
+struct TraceJoin {
+    const Range& range;
+    Format format;
+
+    friend ostream& operator<<(ostream& os, const TraceJoin& join) {
+        for (const auto& item : join.range) os << join.format(item) << " ";
+        return os;
+    }
+};
+
+template <typename Range, typename Format>
+inline TraceJoin<Range, Format> traceJoin(const Range& range, Format format) {
+    return {range, move(format)};
+}
+
+template <typename Range>
+inline auto traceJoin(const Range& range) {
+    return traceJoin(range, [](const auto& item) -> const auto& { return item; });
+}
+
+// SLR_LOG(级别, 流表达式)：如 SLR_LOG(TRACE_DEBUG, "state " << s);
+// 级别超出SLR_TRACE时整条语句在编译期被丢弃，表达式不会求值
+#define SLR_LOG(level, expr)                                    \
+    do {                                                        \
+        if constexpr (SLR_TRACE >= (level)) {                   \
+            if (traceEnabled(level)) {                          \
+                ostringstream traceStream_;                     \
+                traceStream_ << expr;                           \
+                traceWrite(level, traceStream_.str());          \
+            }                                                   \
+        }                                                       \
+    } while (0)
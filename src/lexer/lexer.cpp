@@ -1,7 +1,19 @@
+#ifndef LEXER_CPP
+#define LEXER_CPP
+
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_map>
+#include <deque>
+#include <memory>
+#include <cstdint>
+#include <array>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "simd_scan.h"
+#include "source_buffer.h"
 #include <cctype>
 
 using namespace std;
@@ -19,54 +31,241 @@ enum TokenType {
     UNKNOWN     // 未知
 };
 
+// 细分的词法单元种类：每个关键字、运算符、分隔符各占一种，分析器据此直接查表，无需比较字符串
+enum TokenKind : uint8_t {
+    TK_IDENTIFIER, TK_NUMBER, TK_STRING, TK_END, TK_UNKNOWN,
+
+    // 关键字
+    TK_INT, TK_FLOAT, TK_DOUBLE, TK_CHAR, TK_VOID, TK_BOOL,
+    TK_IF, TK_ELSE, TK_WHILE, TK_FOR, TK_RETURN, TK_CLASS,
+    TK_STRUCT, TK_TRUE, TK_FALSE,
+
+    // 运算符
+    TK_PLUS, TK_MINUS, TK_STAR, TK_SLASH, TK_ASSIGN, TK_EQ, TK_NE,
+    TK_LT, TK_LE, TK_GT, TK_GE, TK_AND, TK_OR, TK_NOT, TK_INC, TK_DEC,
+    TK_PLUS_ASSIGN, TK_MINUS_ASSIGN, TK_STAR_ASSIGN, TK_SLASH_ASSIGN,
+
+    // 分隔符
+    TK_LPAREN, TK_RPAREN, TK_LBRACE, TK_RBRACE, TK_LBRACKET, TK_RBRACKET,
+    TK_SEMICOLON, TK_COMMA, TK_DOT, TK_COLON, TK_SCOPE,
+
+    TOKEN_KIND_COUNT
+};
+
+// 各种类的书写形式；标识符、字面量等可变文本的种类使用文法中的终结符名
+inline constexpr const char* tokenKindSpelling(TokenKind kind) {
+    constexpr const char* spellings[TOKEN_KIND_COUNT] = {
+        "IDENTIFIER", "NUMBER", "STRING", "$", "UNKNOWN",
+        "int", "float", "double", "char", "void", "bool",
+        "if", "else", "while", "for", "return", "class",
+        "struct", "true", "false",
+        "+", "-", "*", "/", "=", "==", "!=",
+        "<", "<=", ">", ">=", "&&", "||", "!", "++", "--",
+        "+=", "-=", "*=", "/=",
+        "(", ")", "{", "}", "[", "]",
+        ";", ",", ".", ":", "::"
+    };
+    return spellings[kind];
+}
+
+// 种类所属的大类
+inline TokenType tokenKindType(TokenKind kind) {
+    if (kind >= TK_INT && kind <= TK_FALSE) return KEYWORD;
+    if (kind >= TK_PLUS && kind <= TK_SLASH_ASSIGN) return OPERATOR;
+    if (kind >= TK_LPAREN && kind <= TK_SCOPE) return DELIMITER;
+    switch (kind) {
+        case TK_IDENTIFIER: return IDENTIFIER;
+        case TK_NUMBER:     return NUMBER;
+        case TK_STRING:     return STRING;
+        case TK_END:        return $;
+        default:            return UNKNOWN;
+    }
+}
+
 // 词法单元结构
+// value不拥有文本：它指向源缓冲区，只有含转义的字符串字面量才指向词法分析器保存的反转义副本
 struct Token {
     TokenType type;
-    string value;
-    size_t line;
+    TokenKind kind;
+    uint32_t line;
+    uint32_t offset;    // 在源缓冲区中的起始偏移
+    uint32_t length;    // 在源缓冲区中占用的字节数(字符串字面量含引号)
+    string_view value;
 
     // 构造函数
-    Token() : type(UNKNOWN), value(""), line(0) {}
-    Token(TokenType t, const string& v, size_t l) : type(t), value(v), line(l) {}
+    Token() : type(UNKNOWN), kind(TK_UNKNOWN), line(0), offset(0), length(0) {}
+    Token(TokenKind k, string_view v, size_t l, size_t off = 0)
+        : Token(k, v, l, off, v.size()) {}
+    Token(TokenKind k, string_view v, size_t l, size_t off, size_t len)
+        : type(tokenKindType(k)), kind(k), line(static_cast<uint32_t>(l)),
+          offset(static_cast<uint32_t>(off)), length(static_cast<uint32_t>(len)), value(v) {}
     
     // 如果需要，可以添加比较运算符
     bool operator==(const Token& other) const {
-        return type == other.type && 
+        return kind == other.kind && 
                value == other.value && 
                line == other.line;
     }
 };
 
+// ---------------- 词法DFA ----------------
+// 字符先经256项的字符类表归类，再按(状态, 字符类)查转移表；表在编译期生成
+
+enum CharClass : uint8_t {
+    CC_OTHER, CC_SPACE, CC_NEWLINE, CC_DIGIT, CC_LETTER, CC_QUOTE, CC_DOT,
+    CC_PLUS, CC_MINUS, CC_STAR, CC_SLASH, CC_EQ, CC_BANG, CC_LT, CC_GT,
+    CC_AMP, CC_PIPE, CC_COLON, CC_LPAREN, CC_RPAREN, CC_LBRACE, CC_RBRACE,
+    CC_LBRACKET, CC_RBRACKET, CC_SEMICOLON, CC_COMMA,
+    CHAR_CLASS_COUNT
+};
+
+inline constexpr array<uint8_t, 256> makeCharClassTable() {
+    array<uint8_t, 256> table{};
+    for (int c = 'a'; c <= 'z'; ++c) table[c] = CC_LETTER;
+    for (int c = 'A'; c <= 'Z'; ++c) table[c] = CC_LETTER;
+    for (int c = '0'; c <= '9'; ++c) table[c] = CC_DIGIT;
+    table['_'] = CC_LETTER;
+    table[' '] = table['\t'] = table['\r'] = table['\v'] = table['\f'] = CC_SPACE;
+    table['\n'] = CC_NEWLINE;
+    table['"'] = CC_QUOTE;   table['.'] = CC_DOT;
+    table['+'] = CC_PLUS;    table['-'] = CC_MINUS;  table['*'] = CC_STAR;  table['/'] = CC_SLASH;
+    table['='] = CC_EQ;      table['!'] = CC_BANG;   table['<'] = CC_LT;    table['>'] = CC_GT;
+    table['&'] = CC_AMP;     table['|'] = CC_PIPE;   table[':'] = CC_COLON;
+    table['('] = CC_LPAREN;  table[')'] = CC_RPAREN; table['{'] = CC_LBRACE; table['}'] = CC_RBRACE;
+    table['['] = CC_LBRACKET; table[']'] = CC_RBRACKET;
+    table[';'] = CC_SEMICOLON; table[','] = CC_COMMA;
+    return table;
+}
+
+inline constexpr array<uint8_t, 256> kCharClass = makeCharClassTable();
+
+// DFA状态：前面是可能继续延伸的中间状态，其后每个Token种类各有一个终态(无出边)
+enum LexState : uint8_t {
+    LS_START, LS_IDENT, LS_INT, LS_FRAC,
+    LS_PLUS, LS_MINUS, LS_STAR, LS_SLASH, LS_EQ, LS_BANG, LS_LT, LS_GT,
+    LS_AMP, LS_PIPE, LS_COLON,
+    LS_FINAL,                                   // LS_FINAL + kind：识别出kind后即停止
+    LEX_STATE_COUNT = LS_FINAL + TOKEN_KIND_COUNT,
+    LS_DEAD = 0xFF
+};
+
+struct LexerDfa {
+    array<array<uint8_t, CHAR_CLASS_COUNT>, LEX_STATE_COUNT> next;
+    array<TokenKind, LEX_STATE_COUNT> accept;   // 在该状态停止时产生的种类，TK_UNKNOWN表示不接受
+};
+
+inline constexpr LexerDfa makeLexerDfa() {
+    LexerDfa dfa{};
+    for (auto& row : dfa.next) {
+        for (auto& target : row) target = LS_DEAD;
+    }
+    for (auto& kind : dfa.accept) kind = TK_UNKNOWN;
+
+    auto final = [](TokenKind kind) { return static_cast<uint8_t>(LS_FINAL + kind); };
+    auto& start = dfa.next[LS_START];
+
+    // 标识符与数字
+    start[CC_LETTER] = LS_IDENT;
+    dfa.next[LS_IDENT][CC_LETTER] = LS_IDENT;
+    dfa.next[LS_IDENT][CC_DIGIT] = LS_IDENT;
+    dfa.accept[LS_IDENT] = TK_IDENTIFIER;
+    start[CC_DIGIT] = LS_INT;
+    dfa.next[LS_INT][CC_DIGIT] = LS_INT;
+    dfa.next[LS_INT][CC_DOT] = LS_FRAC;
+    dfa.next[LS_FRAC][CC_DIGIT] = LS_FRAC;
+    dfa.accept[LS_INT] = TK_NUMBER;
+    dfa.accept[LS_FRAC] = TK_NUMBER;
+
+    // 可延伸为双字符的运算符/分隔符：首字符状态、单独出现时的种类，以及各第二字符的转移
+    struct Prefix { CharClass first; LexState state; TokenKind alone; CharClass second[2]; TokenKind pair[2]; };
+    const Prefix prefixes[] = {
+        {CC_PLUS,  LS_PLUS,  TK_PLUS,    {CC_PLUS,  CC_EQ},    {TK_INC, TK_PLUS_ASSIGN}},
+        {CC_MINUS, LS_MINUS, TK_MINUS,   {CC_MINUS, CC_EQ},    {TK_DEC, TK_MINUS_ASSIGN}},
+        {CC_STAR,  LS_STAR,  TK_STAR,    {CC_EQ,    CC_OTHER}, {TK_STAR_ASSIGN, TK_UNKNOWN}},
+        {CC_SLASH, LS_SLASH, TK_SLASH,   {CC_EQ,    CC_OTHER}, {TK_SLASH_ASSIGN, TK_UNKNOWN}},
+        {CC_EQ,    LS_EQ,    TK_ASSIGN,  {CC_EQ,    CC_OTHER}, {TK_EQ, TK_UNKNOWN}},
+        {CC_BANG,  LS_BANG,  TK_NOT,     {CC_EQ,    CC_OTHER}, {TK_NE, TK_UNKNOWN}},
+        {CC_LT,    LS_LT,    TK_LT,      {CC_EQ,    CC_OTHER}, {TK_LE, TK_UNKNOWN}},
+        {CC_GT,    LS_GT,    TK_GT,      {CC_EQ,    CC_OTHER}, {TK_GE, TK_UNKNOWN}},
+        {CC_AMP,   LS_AMP,   TK_UNKNOWN, {CC_AMP,   CC_OTHER}, {TK_AND, TK_UNKNOWN}},
+        {CC_PIPE,  LS_PIPE,  TK_UNKNOWN, {CC_PIPE,  CC_OTHER}, {TK_OR, TK_UNKNOWN}},
+        {CC_COLON, LS_COLON, TK_COLON,   {CC_COLON, CC_OTHER}, {TK_SCOPE, TK_UNKNOWN}},
+    };
+    for (const Prefix& prefix : prefixes) {
+        start[prefix.first] = prefix.state;
+        dfa.accept[prefix.state] = prefix.alone;
+        for (int i = 0; i < 2; ++i) {
+            if (prefix.pair[i] != TK_UNKNOWN) dfa.next[prefix.state][prefix.second[i]] = final(prefix.pair[i]);
+        }
+    }
+
+    // 单字符分隔符
+    start[CC_DOT] = final(TK_DOT);
+    start[CC_LPAREN] = final(TK_LPAREN);
+    start[CC_RPAREN] = final(TK_RPAREN);
+    start[CC_LBRACE] = final(TK_LBRACE);
+    start[CC_RBRACE] = final(TK_RBRACE);
+    start[CC_LBRACKET] = final(TK_LBRACKET);
+    start[CC_RBRACKET] = final(TK_RBRACKET);
+    start[CC_SEMICOLON] = final(TK_SEMICOLON);
+    start[CC_COMMA] = final(TK_COMMA);
+
+    for (int kind = 0; kind < TOKEN_KIND_COUNT; ++kind) {
+        dfa.accept[LS_FINAL + kind] = static_cast<TokenKind>(kind);
+    }
+    return dfa;
+}
+
+inline constexpr LexerDfa kLexerDfa = makeLexerDfa();
+
+// 关键字完美哈希：(首字符 + 4*次字符 + 长度) mod 32 对全部关键字互不冲突(所有关键字长度不小于2)
+struct KeywordSlot {
+    const char* spelling;
+    uint8_t length;
+    TokenKind kind;
+};
+
+inline constexpr size_t kKeywordSlots = 32;
+
+inline constexpr size_t keywordHash(unsigned char first, unsigned char second, size_t length) {
+    return (first + 4u * second + length) & (kKeywordSlots - 1);
+}
+
+inline constexpr array<KeywordSlot, kKeywordSlots> makeKeywordTable() {
+    array<KeywordSlot, kKeywordSlots> table{};
+    for (auto& slot : table) slot = {"", 0, TK_IDENTIFIER};
+    for (int kind = TK_INT; kind <= TK_FALSE; ++kind) {
+        const char* spelling = tokenKindSpelling(static_cast<TokenKind>(kind));
+        size_t length = 0;
+        while (spelling[length] != '\0') ++length;
+        KeywordSlot& slot = table[keywordHash(spelling[0], spelling[1], length)];
+        if (slot.length != 0) throw logic_error("keyword hash collision");  // 编译期求值时即报错
+        slot = {spelling, static_cast<uint8_t>(length), static_cast<TokenKind>(kind)};
+    }
+    return table;
+}
+
+inline constexpr array<KeywordSlot, kKeywordSlots> kKeywords = makeKeywordTable();
+
+// 标识符若是关键字则返回对应种类，否则返回TK_IDENTIFIER
+inline TokenKind classifyIdentifier(string_view text) {
+    if (text.size() < 2) return TK_IDENTIFIER;
+    const KeywordSlot& slot = kKeywords[keywordHash(text[0], text[1], text.size())];
+    return slot.length == text.size() && memcmp(slot.spelling, text.data(), text.size()) == 0
+        ? slot.kind : TK_IDENTIFIER;
+}
+
 // 词法分析器类
+// 不复制源代码：以string_view构造时，调用者需保证源缓冲区在词法分析器及其产生的Token使用期间有效；
+// 以SourceBuffer构造时由词法分析器(及其副本)共同持有缓冲区
 class Lexer {
 private:
-    string source;
+    shared_ptr<const SourceBuffer> buffer;
+    string_view source;
     size_t pos;
     size_t line;
-
-    const unordered_map<string, TokenType> Keywords = {
-        {"int", KEYWORD}, {"float", KEYWORD}, {"double", KEYWORD},
-        {"char", KEYWORD}, {"void", KEYWORD}, {"bool", KEYWORD},
-        {"if", KEYWORD}, {"else", KEYWORD}, {"while", KEYWORD},
-        {"for", KEYWORD}, {"return", KEYWORD}, {"class", KEYWORD},
-        {"struct", KEYWORD}, {"true", KEYWORD}, {"false", KEYWORD}
-    };
-
-    // 运算符集合
-    const unordered_map<string, TokenType> operators = {
-        {"+", OPERATOR}, {"-", OPERATOR}, {"*", OPERATOR}, {"/", OPERATOR},
-        {"=", OPERATOR}, {"==", OPERATOR}, {"!=", OPERATOR}, {"<", OPERATOR},
-        {"<=", OPERATOR}, {">", OPERATOR}, {">=", OPERATOR}, {"&&", OPERATOR},
-        {"||", OPERATOR}, {"!", OPERATOR}, {"++", OPERATOR}, {"--", OPERATOR},
-        {"+=", OPERATOR}, {"-=", OPERATOR}, {"*=", OPERATOR}, {"/=", OPERATOR}
-    };
-
-    // 分隔符集合
-    const unordered_map<string, TokenType> delimiters = {
-        {"(", DELIMITER}, {")", DELIMITER}, {"{", DELIMITER}, {"}", DELIMITER},
-        {"[", DELIMITER}, {"]", DELIMITER}, {";", DELIMITER}, {",", DELIMITER},
-        {".", DELIMITER}, {":", DELIMITER}, {"::", DELIMITER}
-    };
+    shared_ptr<deque<string>> literals;  // 含转义的字符串字面量的反转义结果(deque保证地址稳定)
+    const ScanKernels* scan;             // 空白、注释、标识符等长串的批量扫描实现
 
     char peek(size_t offset = 0) const {
         if (pos + offset >= source.length()) return '\0';
@@ -77,78 +276,66 @@ private:
         pos++;
     }
 
-    bool isOperator(char c) const {
-        string op(1, c);
-        return operators.find(op) != operators.end();
-    }
-
-    bool isDelimiter(char c) const {
-        string delim(1, c);
-        return delimiters.find(delim) != delimiters.end();
-    }
+    const char* cursor() const { return source.data() + pos; }
+    const char* limit() const { return source.data() + source.length(); }
+    void seek(const char* p) { pos = static_cast<size_t>(p - source.data()); }
 
-    Token readNumber() {
-        string value;
-        bool hasDecimal = false;
-        
+    // 从当前位置按最长匹配运行DFA，识别一个标识符、数字、运算符或分隔符
+    Token readToken() {
+        const size_t start = pos;
+        uint8_t state = LS_START;
         while (pos < source.length()) {
-            char current = peek();
-            
-            if (isdigit(current)) {
-                value += current;
-                consume();
-            }
-            else if (current == '.' && !hasDecimal) {
-                hasDecimal = true;
-                value += current;
-                consume();
-            }
-            else {
-                break;
-            }
+            uint8_t next = kLexerDfa.next[state][kCharClass[static_cast<unsigned char>(source[pos])]];
+            if (next == LS_DEAD) break;
+            state = next;
+            pos++;
+            // 标识符和数字的连续字符整段跳过，DFA只处理其边界
+            if (state == LS_IDENT) seek(scan->skipIdentifier(cursor(), limit()));
+            else if (state == LS_INT || state == LS_FRAC) seek(scan->skipDigits(cursor(), limit()));
         }
-        
-        return {NUMBER, value, line};
+
+        // 起始字符无法开始任何Token：单独作为未知字符
+        if (pos == start) pos++;
+        string_view value = source.substr(start, pos - start);
+        TokenKind kind = kLexerDfa.accept[state];
+        if (kind == TK_IDENTIFIER) kind = classifyIdentifier(value);
+        return {kind, value, line, start};
     }
 
-    Token readIdentifier() {
-        string value;
+    Token readString() {
+        size_t start = pos;
+        consume(); // 跳过开始的引号
+        size_t contentStart = pos;
+        bool hasEscape = false;
         
         while (pos < source.length()) {
             char current = peek();
             
-            if (isalnum(current) || current == '_') {
-                value += current;
+            if (current == '\\') { // 转义字符，稍后统一处理
+                hasEscape = true;
                 consume();
+                if (pos < source.length()) consume();  // 未闭合的字面量可能以'\\'结尾，不越过缓冲区末尾
             }
-            else {
+            else if (current == '"') { // 结束引号
                 break;
             }
-        }
-
-        // 检查关键字
-        if (Keywords.find(value) != Keywords.end()) {
-            auto it = Keywords.find(value);
-            if (it != Keywords.end()) {
-                return {it->second, value, line};
+            else {
+                consume();
             }
         }
-        // 其他情况视为标识符
-        else {
-            return {IDENTIFIER, value, line};
+
+        size_t contentEnd = pos;
+        if (pos < source.length()) consume(); // 跳过结束引号
+        string_view raw = source.substr(contentStart, contentEnd - contentStart);
+        if (!hasEscape) {
+            return {TK_STRING, raw, line, start, pos - start};
         }
-    }
 
-    Token readString() {
+        // 只有含转义的字面量才需要生成新的字符串
         string value;
-        consume(); // 跳过开始的引号
-        
-        while (pos < source.length()) {
-            char current = peek();
-            
-            if (current == '\\') { // 处理转义字符
-                consume();
-                char next = peek();
+        for (size_t i = 0; i < raw.size(); ++i) {
+            if (raw[i] == '\\' && i + 1 < raw.size()) {
+                char next = raw[++i];
                 switch (next) {
                     case 'n': value += '\n'; break;
                     case 't': value += '\t'; break;
@@ -156,152 +343,126 @@ private:
                     case '\\': value += '\\'; break;
                     default: value += next; break;
                 }
-                consume();
             }
-            else if (current == '"') { // 结束引号
-                consume();
-                break;
-            }
-            else {
-                value += current;
-                consume();
+            else if (raw[i] != '\\') {
+                value += raw[i];
             }
         }
-        
-        return {STRING, value, line};
+        literals->push_back(move(value));
+        return {TK_STRING, literals->back(), line, start, pos - start};
     }
 
     void readLineComment() {
-        consume(); // 跳过第一个'/'
-        consume(); // 跳过第二个'/'
-        
-        while (pos < source.length()) {
-            if (peek() == '\n') {
-                line++;
-                consume();
-                break;
-            }
-            consume();
+        const char* newline = scan->findNewline(cursor() + 2, limit());
+        if (newline < limit()) {
+            line++;
+            newline++;
         }
+        seek(newline);
     }
 
     void readBlockComment() {
-        consume(); // 跳过第一个'/'
-        consume(); // 跳过第二个'*'
-        
-        while (pos < source.length()) {
-            if (peek() == '*' && peek(1) == '/') {
-                consume(); // 跳过'*'
-                consume(); // 跳过'/'
-                break;
-            }
-            if (peek() == '\n') {
-                line++;
-            }
-            consume();
-        }
+        const char* body = cursor() + 2;
+        const char* close = scan->findCommentEnd(body, limit());
+        line += scan->countNewlines(body, close);
+        seek(close < limit() ? close + 2 : limit());
     }
 
-    Token readOperator() {
-        string value;
-        value += peek();
-        consume();
-        
-        // 检查是否是双字符运算符
-        if (pos < source.length()) {
-            string twoCharOp = value + peek();
-            if (operators.find(twoCharOp) != operators.end()) {
-                value += peek();
-                consume();
-            }
-        }
-        
-        auto it = operators.find(value);
-        if (it != operators.end()) {
-            return {it->second, value, line};
-        }
+    void skipWhitespace() {
+        size_t newlines = 0;
+        seek(scan->skipWhitespace(cursor(), limit(), newlines));
+        line += newlines;
     }
 
-    Token readDelimiter() {
-        string value;
-        value += peek();
-        consume();
-        
-        // 处理单字符分隔符
-        auto it = delimiters.find(value);
-        if (it != delimiters.end()) {
-            return {it->second, value, line};
-        }
-        
-        // 处理多字符分隔符（如 "::"）
-        if (value.size() > 1) {
-            it = delimiters.find(value);
-            if (it != delimiters.end()) {
-                return {it->second, value, line};
-            }
-        }
-        
-        return {UNKNOWN, value, line}; // 无效分隔符
+public:
+    Lexer(string_view source)
+        : source(source), pos(0), line(1), literals(make_shared<deque<string>>()), scan(&scanKernels()) {}
+    Lexer(const char* source) : Lexer(string_view(source)) {}
+    Lexer(const string& source) : Lexer(string_view(source)) {}
+    // 临时字符串会在Token使用前销毁，禁止绑定
+    Lexer(string&&) = delete;
+    explicit Lexer(shared_ptr<const SourceBuffer> input) : Lexer(input->text()) { buffer = move(input); }
+
+    // 源代码文本及其所有者(以string_view构造时所有者为空)
+    string_view sourceText() const { return source; }
+    const shared_ptr<const SourceBuffer>& sourceBuffer() const { return buffer; }
+
+    // 指定扫描实现(默认按CPU特性自动选择)，供基准测试对比标量路径
+    void useScanKernels(const ScanKernels& kernels) { scan = &kernels; }
+
+    // 从指定偏移处继续切分(用于增量分析时只重新切分编辑过的部分)。
+    // 偏移须位于两个Token之间而不在注释或字符串内部，lineNumber为该处的行号
+    void restartAt(size_t offset, size_t lineNumber) {
+        pos = min(offset, source.length());
+        line = lineNumber;
     }
 
-public:
-    Lexer(const string& source) : source(source), pos(0), line(1) {}
+    // 下一次切分的起点及该处的行号(分块分析时据此保留不完整的尾部)
+    size_t position() const { return pos; }
+    size_t lineNumber() const { return line; }
 
-    vector<Token> tokenize() {
-        vector<Token> tokens;
-        
+    // 拉取下一个词法单元；输入耗尽后(含之后的每次调用)返回TK_END
+    Token next() {
         while (pos < source.length()) {
-            char current = peek();
+            const unsigned char current = static_cast<unsigned char>(source[pos]);
             
-            if (isspace(current)) {
-                consume();
-                if (current == '\n') line++;
-            }
-            else if (isdigit(current)) {
-                tokens.push_back(readNumber());
-            }
-            else if (isalpha(current) || current == '_') {
-                tokens.push_back(readIdentifier());
-            }
-            else if (current == '"') {
-                tokens.push_back(readString());
-            }
-            else if (current == '/' && peek(1) == '/') {
-                readLineComment();
-            }
-            else if (current == '/' && peek(1) == '*') {
-                readBlockComment();
-            }
-            else if (isOperator(current)) {
-                tokens.push_back(readOperator());
-            }
-            else if (isDelimiter(current)) {
-                tokens.push_back(readDelimiter());
-            }
-            else {
-                tokens.push_back({UNKNOWN, string(1, current), line});
-                consume();
+            switch (kCharClass[current]) {
+                case CC_NEWLINE:
+                case CC_SPACE:
+                    skipWhitespace();
+                    break;
+                case CC_QUOTE:
+                    return readString();
+                case CC_SLASH:
+                    if (peek(1) == '/') {
+                        readLineComment();
+                        break;
+                    }
+                    if (peek(1) == '*') {
+                        readBlockComment();
+                        break;
+                    }
+                    return readToken();
+                default:
+                    return readToken();
             }
         }
         
+        return {TK_END, "$", line, source.length(), 0};
+    }
+
+    // 一次性切分全部输入(不含结束标记)
+    vector<Token> tokenize() {
+        vector<Token> tokens;
+        tokens.reserve(source.length() / 4 + 1);
+        for (Token token = next(); token.kind != TK_END; token = next()) {
+            tokens.push_back(token);
+        }
         return tokens;
     }
 };
 
+// 打印单个词法单元
+inline void printToken(const Token& token) {
+    string typeStr;
+    switch (token.type) {
+        case KEYWORD: typeStr = "KEYWORD"; break;
+        case IDENTIFIER: typeStr = "IDENTIFIER"; break;
+        case NUMBER: typeStr = "NUMBER"; break;
+        case OPERATOR: typeStr = "OPERATOR"; break;
+        case DELIMITER: typeStr = "DELIMITER"; break;
+        case STRING: typeStr = "STRING"; break;
+        case COMMENT: typeStr = "COMMENT"; break;
+        case UNKNOWN: typeStr = "UNKNOWN"; break;
+    }
+    cout << "[" << typeStr << ": " << token.value << "] (Line " << token.line << ")" << endl;
+}
+
 // 打印词法分析结果
 inline void printTokens(const vector<Token>& tokens) {
     for (const auto& token : tokens) {
-        string typeStr;
-        switch (token.type) {
-            case KEYWORD: typeStr = "KEYWORD"; break;
-            case IDENTIFIER: typeStr = "IDENTIFIER"; break;
-            case NUMBER: typeStr = "NUMBER"; break;
-            case OPERATOR: typeStr = "OPERATOR"; break;
-            case DELIMITER: typeStr = "DELIMITER"; break;
-            case STRING: typeStr = "STRING"; break;
-            case COMMENT: typeStr = "COMMENT"; break;
-            case UNKNOWN: typeStr = "UNKNOWN"; break;
-        }
-        cout << "[" << typeStr << ": " << token.value << "] (Line " << token.line << ")" << endl;
+        printToken(token);
     }
-}
\ No newline at end of file
+}
+
+#endif
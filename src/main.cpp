@@ -1,8 +1,113 @@
 #include "./parser/parser.cpp"
+#include "./parser/batch_parser.h"
+#include "./parser/split_parser.h"
+#include "./parser/stream_parser.h"
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
 
-int main() {
+// 打印一条移进/归约事件
+static void printEvent(const ParseEvent& event, const SymbolTable& symbols) {
+    static const char* const kEventNames[] = {"shift ", "reduce ", "append "};
+    cout << kEventNames[event.type] << symbols.name(event.symbol)
+         << " [" << event.span.begin << ", " << event.span.end << ")";
+    if (event.type == REDUCE_EVENT) cout << " children=" << event.childCount;
+    cout << '\n';
+}
+
+int main(int argc, char** argv) {
     cout << "Program started" << endl;
 
+    // --table <文件>：使用tablegen预先生成的二进制分析表，跳过运行时建表
+    // --tokens：额外打印词法分析结果
+    // --output tree|flat|events：输出语法树(默认)、扁平后序节点数组或移进/归约事件流
+    // --trace <0-4>：跟踪输出级别(需以SLR_TRACE=ON构建才能输出错误以外的级别)
+    // --jobs <N>：批量分析时的工作线程数(默认每个硬件线程一个)
+    // --max-depth <N>：分析栈深度上限，超过时报告栈溢出
+    // --split：单个源文件在顶层语句边界切分，按--jobs个线程并行分析后拼成一棵语法树；
+    //          只用于默认的--output tree，与flat/events输出、--stream或多个源文件同用时报告用法错误
+    // --stream：按64KB分块读入源文件并逐块分析(不映射、不缓存整个输入)，输出移进/归约事件流
+    // <源文件>...：分析指定文件("-"表示标准输入)，缺省时分析内置示例；给出多个文件时并行批量分析
+    // 未知的"--"选项或缺少取值的选项报告用法错误并以状态2退出
+    string tableFile;
+    vector<string> sourceFiles;
+    size_t jobs = thread::hardware_concurrency();
+    size_t maxDepth = kDefaultMaxParseDepth;
+    string outputMode = "tree";
+    bool showTokens = false;
+    bool streamInput = false;
+    bool splitInput = false;
+    auto usageError = [&argv](const string& message) {
+        cerr << "Error: " << message << "\nUsage: " << argv[0]
+             << " [--table FILE] [--tokens] [--output tree|flat|events] [--trace N] [--jobs N] [--max-depth N]"
+                " [--split] [--stream] [SOURCE...]" << endl;
+        return 2;
+    };
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        const bool takesValue = arg == "--table" || arg == "--output" || arg == "--trace" || arg == "--jobs" ||
+                                arg == "--max-depth";
+        if (takesValue && i + 1 >= argc) {
+            return usageError("missing value for " + arg);
+        }
+        if (arg == "--table") {
+            tableFile = argv[++i];
+        } else if (arg == "--output") {
+            outputMode = argv[++i];
+        } else if (arg == "--trace") {
+            setTraceLevel(static_cast<TraceLevel>(atoi(argv[++i])));
+        } else if (arg == "--jobs") {
+            jobs = static_cast<size_t>(atoi(argv[++i]));
+        } else if (arg == "--max-depth") {
+            maxDepth = static_cast<size_t>(strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--tokens") {
+            showTokens = true;
+        } else if (arg == "--split") {
+            splitInput = true;
+        } else if (arg == "--stream") {
+            streamInput = true;
+        } else if (arg.compare(0, 2, "--") == 0) {
+            // 拼错的选项不能当作源文件，否则会悄悄变成批量分析
+            return usageError("unknown option " + arg);
+        } else {
+            sourceFiles.push_back(arg);
+        }
+    }
+    if (splitInput && (outputMode != "tree" || streamInput || sourceFiles.size() > 1)) {
+        return usageError("--split only builds a syntax tree for a single source file");
+    }
+
+    // 多个文件：共享一份编译好的文法，在线程池中并行分析，按输入顺序汇报结果
+    if (sourceFiles.size() > 1) {
+        try {
+            shared_ptr<const CompiledGrammar> grammar =
+                tableFile.empty() ? SyntaxParser::compileGrammar()
+                                  : make_shared<const CompiledGrammar>(loadTableFile(tableFile));
+            vector<FileParseResult> results = parseFiles(grammar, sourceFiles, jobs, maxDepth);
+            int failed = 0;
+            size_t maxStackDepth = 0;
+            for (const FileParseResult& result : results) {
+                maxStackDepth = max(maxStackDepth, result.maxStackDepth);
+                if (!result.error.empty()) {
+                    cout << result.path << ": error: " << result.error << endl;
+                } else {
+                    for (const ParseDiagnostic& diag : result.diagnostics) {
+                        cout << result.path << ":" << diag.line << ": " << diag.message << endl;
+                    }
+                    cout << result.path << ": " << (result.ok() ? "ok" : "recovered") << endl;
+                }
+                if (!result.ok()) ++failed;
+            }
+            cout << results.size() - failed << "/" << results.size() << " files parsed without errors" << endl;
+            cout << "max parse stack depth: " << maxStackDepth << " (limit " << maxDepth << ")" << endl;
+            return failed == 0 ? 0 : 1;
+        } catch (const exception& e) {
+            cerr << "Error: " << e.what() << endl;
+            return 1;
+        }
+    }
+    string sourceFile = sourceFiles.empty() ? string() : sourceFiles.front();
+
     string code = R"(
         int x;
         x = 10;
@@ -18,16 +123,75 @@ int main() {
         }
     )";
     
-    Lexer lexer(code);
-    SyntaxParser parser(lexer);
-
-    vector<Token> tokens = lexer.tokenize();
-    printTokens(tokens);
-    
     try {
-        shared_ptr<SyntaxTreeNode> syntaxTree = parser.parse();
-        cout << "\nSyntax Tree:"<< endl;
-        printSyntaxTree(syntaxTree);
+        if (streamInput) {
+            shared_ptr<const CompiledGrammar> grammar =
+                tableFile.empty() ? SyntaxParser::compileGrammar()
+                                  : make_shared<const CompiledGrammar>(loadTableFile(tableFile));
+            const SymbolTable& symbols = *grammar->symbols();
+            auto sink = makeEventSink([&symbols](const ParseEvent& event) { printEvent(event, symbols); });
+            StreamParser<decltype(sink)> parser(grammar, sink, maxDepth);
+
+            istringstream sample(code);
+            ifstream file;
+            istream* input = &sample;
+            if (sourceFile == "-") {
+                input = &cin;
+            } else if (!sourceFile.empty()) {
+                file.open(sourceFile, ios::binary);
+                if (!file.is_open()) throw runtime_error("Failed to open file " + sourceFile);
+                input = &file;
+            }
+
+            vector<char> chunk(64 * 1024);
+            while (input->read(chunk.data(), static_cast<streamsize>(chunk.size())) || input->gcount() > 0) {
+                parser.feed(string_view(chunk.data(), static_cast<size_t>(input->gcount())));
+            }
+            parser.finish();
+            for (const ParseDiagnostic& diag : parser.diagnostics()) {
+                cout << diag.line << ": " << diag.message << endl;
+            }
+            return 0;
+        }
+
+        shared_ptr<const SourceBuffer> source = sourceFile.empty() ? SourceBuffer::fromString(code, "<sample>")
+                                                                   : SourceBuffer::open(sourceFile);
+        Lexer lexer(source);
+
+        SyntaxParser parser = tableFile.empty() ? SyntaxParser(lexer)
+                                                : SyntaxParser(lexer, loadTableFile(tableFile));
+        parser.setMaxStackDepth(maxDepth);
+
+        if (showTokens) {
+            Lexer tokenLexer(source);
+            for (Token token = tokenLexer.next(); token.kind != TK_END; token = tokenLexer.next()) {
+                printToken(token);
+            }
+        }
+
+        if (outputMode == "flat") {
+            FlatSink sink;
+            FlatTree flat = parser.parse(sink);
+            cout << "\nPostorder Nodes:" << endl;
+            for (const FlatNode& node : flat.nodes) {
+                cout << flat.symbols->name(node.symbol) << "\t[" << node.begin << ", " << node.end << ")\t"
+                     << node.childCount << endl;
+            }
+        } else if (outputMode == "events") {
+            const SymbolTable& symbols = parser.getSymbols();
+            auto sink = makeEventSink([&symbols](const ParseEvent& event) { printEvent(event, symbols); });
+            parser.parse(sink);
+        } else {
+            SyntaxTree syntaxTree;
+            if (splitInput) {
+                ThreadPool pool(jobs);
+                syntaxTree = parseSplit(parser.grammar(), lexer, pool, nullptr, maxDepth);
+            } else {
+                syntaxTree = parser.parse();
+            }
+            cout << "\nSyntax Tree:"<< endl;
+            printSyntaxTree(syntaxTree);
+        }
     } catch (const exception& e) {
         cerr << "Error: " << e.what() << endl;
     }
@@ -0,0 +1,57 @@
+#pragma once
+
+// 批量并行分析：所有文件共享同一份只读的CompiledGrammar，每个文件在线程池中
+// 以独立的轻量SyntaxParser(文法指针+词法分析器)分析，互不加锁；
+// 分析栈从共享的ParseStackPool取用，栈组数不超过线程数，各文件之间不再重新分配
+
+#include <exception>
+#include <string>
+#include <vector>
+#include "parser.cpp"
+#include "thread_pool.h"
+
+using namespace std;
+
+// 单个文件的分析结果
+struct FileParseResult {
+    string path;
+    SyntaxTree tree;                       // 分析失败(error非空)时为空树
+    vector<ParseDiagnostic> diagnostics;   // 已恢复的语法错误
+    string error;                          // 无法继续分析的错误(打开文件失败、恢复失败、栈溢出等)
+    size_t maxStackDepth = 0;              // 分析栈的最大深度
+
+    bool ok() const { return error.empty() && diagnostics.empty(); }
+};
+
+// 在给定线程池上分析一组文件，结果与输入路径一一对应
+inline vector<FileParseResult> parseFiles(const shared_ptr<const CompiledGrammar>& grammar,
+                                          const vector<string>& paths, ThreadPool& pool,
+                                          ParseStackPool<TreeSink::Value>& stacks) {
+    vector<FileParseResult> results(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        pool.submit([&grammar, &paths, &results, &stacks, i] {
+            FileParseResult& result = results[i];
+            result.path = paths[i];
+            try {
+                SyntaxParser parser(grammar, Lexer(SourceBuffer::open(paths[i])));
+                result.tree = parser.parse(stacks);
+                result.diagnostics = parser.diagnostics();
+                result.maxStackDepth = parser.stackHighWater();
+            } catch (const exception& e) {
+                result.error = e.what();
+            }
+        });
+    }
+    pool.wait();
+    return results;
+}
+
+// 使用临时线程池(默认每个硬件线程一个工作线程)和栈池
+inline vector<FileParseResult> parseFiles(const shared_ptr<const CompiledGrammar>& grammar,
+                                          const vector<string>& paths,
+                                          size_t threadCount = thread::hardware_concurrency(),
+                                          size_t maxStackDepth = kDefaultMaxParseDepth) {
+    ThreadPool pool(threadCount);
+    ParseStackPool<TreeSink::Value> stacks(maxStackDepth);
+    return parseFiles(grammar, paths, pool, stacks);
+}
@@ -0,0 +1,685 @@
+#pragma once
+
+// 增量语法分析：编辑后只重新切分受影响的Token，并整体复用上一次分析得到的未改变子树。
+//
+// 每个节点记录移进其第一个Token之前栈顶的LR状态。重新分析时，上一棵树中未受编辑影响的子树
+// 作为整体出现在输入中：若当前状态与记录的状态相同，且子树之后的Token没有改变(子树内部的归约
+// 只依赖进入状态、子树自身的Token及其后一个Token)，就按GOTO直接压栈而不再逐个移进其中的Token；
+// 否则把它拆成子节点继续尝试，直到叶子。
+//
+// 节点只记录长度(前导空白和Token部分)而不记录绝对位置，编辑点之后的子树无需调整即可复用。
+//
+// 列表(L -> L X追加元素的非终结符)的元素每kListChunk个封口为一个分块，分块再逐层分组，构成平衡树。
+// 每个元素都从同一个状态开始分析、归约后回到同一个栈顶，所以未改变的分块可以整体追加到新列表中，
+// 一次编辑只需新建编辑点所在路径上的O(log N)个分块。分块对文法透明，toSyntaxTree()时展开为列表的直接子节点。
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "parser.cpp"
+
+using namespace std;
+
+struct IncrementalNode {
+    int32_t symbol;          // 终结符或非终结符ID，错误恢复时丢弃的内容为-1，列表分块为所属列表的符号
+    int32_t state;           // 移进该子树第一个Token之前栈顶的LR状态
+    int32_t firstTerminal;   // 第一个Token对应的终结符(空子树或文法中没有该符号时为-1)
+    uint32_t padding;        // 第一个Token之前的空白和注释字节数
+    uint32_t size;           // 第一个Token起点到最后一个Token终点的字节数，空子树为0
+    uint32_t childCount;     // 叶子为0
+    bool reusable;           // 错误恢复之后的归约所用向前看符号与文本不符，不能整体复用
+    uint8_t level;           // 列表分块的层数(子节点为列表元素时为1)，其余节点为0
+    bool indexed;            // 列表及其分块：children之后紧跟各子节点(含前导空白)的累计终点
+    IncrementalNode** children;
+
+    uint32_t width() const { return padding + size; }
+
+    // 相对于本节点(含前导空白)起点的累计终点，按位置查找子节点时二分，仅indexed时有效
+    const uint32_t* childEnds() const { return reinterpret_cast<const uint32_t*>(children + childCount); }
+};
+
+// 最近一次分析的工作量
+struct IncrementalStats {
+    size_t relexedTokens = 0;    // 重新切分得到的Token数
+    size_t reusedSubtrees = 0;   // 整体复用的子树数
+    size_t shiftedTokens = 0;    // 逐个移进的Token数
+    size_t reductions = 0;
+    bool fullParse = false;      // 是否从头完整分析
+};
+
+class IncrementalParser {
+private:
+    using Node = IncrementalNode;
+    static constexpr size_t NO_SUFFIX = static_cast<size_t>(-1);
+    static constexpr size_t kListChunk = 16;  // 列表分块的容量
+
+    shared_ptr<const CompiledGrammar> grammar_;
+    string text_;
+    Arena arena_;               // 新旧树共享节点，旧节点随Arena整理时一并释放
+    size_t compactedBytes_ = 0; // 最近一次完整分析后Arena的大小
+    Node* root_ = nullptr;      // Program节点
+    Node* error_ = nullptr;     // 错误恢复时丢弃的栈内容和跳过的输入，在文本中位于root_之后
+    vector<ParseDiagnostic> diagnostics_;
+    IncrementalStats stats_;
+    int endTerminal_;
+    vector<bool> isList_;       // 按符号ID索引：是否有L -> L X形式的追加产生式
+
+    // 分析栈上仍可追加元素的列表。各列表的元素和已封口的分块依次放在listItems_中，
+    // 自base起层数单调不增；末尾同层的项满kListChunk个即封口为上一层的分块
+    struct OpenList {
+        Node* list;        // 栈上的占位节点，封口时替换为真正的列表节点
+        size_t depth;      // 列表在分析栈中的下标
+        size_t base;       // 在listItems_中的起点
+        size_t topRun;     // 末尾同层的项数
+        bool reusable;
+    };
+    vector<OpenList> openLists_;  // 按在分析栈中的位置排列
+    vector<Node*> listItems_;
+
+    // 重新分析的输入依次为：旧树中[0, prefixEnd)内的子树、重新切分的叶子、旧树中从suffixStart起的子树
+    struct EditRegion {
+        size_t prefixEnd = 0;
+        vector<Node*> tokens;
+        vector<size_t> tokenPositions;  // 各叶子(含前导空白)在新文本中的起点
+        size_t suffixStart = NO_SUFFIX; // 旧文本中的位置
+        ptrdiff_t delta = 0;            // 编辑造成的长度变化
+    };
+
+    // 按文本顺序遍历旧树：current()为当前子树，skip()越过它，descend()把它拆成子节点
+    class TreeCursor {
+    private:
+        struct Frame {
+            Node* const* nodes;
+            uint32_t count;
+            uint32_t index;
+        };
+        Node* top_[2];
+        vector<Frame> frames_;
+        size_t pos_ = 0;  // 当前子树(含前导空白)在旧文本中的起点
+
+        // 越过空子树，弹出已遍历完的层
+        void settle() {
+            while (!frames_.empty()) {
+                Frame& frame = frames_.back();
+                if (frame.index == frame.count) {
+                    frames_.pop_back();
+                } else if (frame.nodes[frame.index] == nullptr || frame.nodes[frame.index]->size == 0) {
+                    frame.index++;
+                } else {
+                    return;
+                }
+            }
+        }
+
+    public:
+        TreeCursor(Node* root, Node* error) : top_{root, error} {
+            frames_.push_back({top_, 2, 0});
+            settle();
+        }
+
+        TreeCursor(const TreeCursor&) = delete;
+        TreeCursor& operator=(const TreeCursor&) = delete;
+
+        Node* current() const { return frames_.empty() ? nullptr : frames_.back().nodes[frames_.back().index]; }
+        size_t position() const { return pos_; }
+
+        void skip() {
+            pos_ += current()->width();
+            frames_.back().index++;
+            settle();
+        }
+
+        // 先越过父层中的该节点，使右递归的长链不会让遍历栈随深度增长
+        void descend() {
+            Node* node = current();
+            if (++frames_.back().index == frames_.back().count) frames_.pop_back();
+            frames_.push_back({node->children, node->childCount, 0});
+            settle();
+        }
+    };
+
+    Node* makeLeaf(const Token& token, size_t paddingStart) {
+        return arena_.create<Node>(grammar_->terminalFor(token), -1, grammar_->terminalFor(token),
+                                   static_cast<uint32_t>(token.offset - paddingStart), token.length, 0u, true,
+                                   uint8_t{0}, false, nullptr);
+    }
+
+    // 由子节点构造父节点，前导空白和第一个终结符取自第一个非空子节点
+    Node* makeParent(int symbol, int state, Node** children, size_t count, bool reusable) {
+        uint32_t width = 0;
+        uint32_t padding = 0;
+        int firstTerminal = -1;
+        for (size_t i = 0; i < count; ++i) {
+            if (width == 0 && children[i]->size != 0) {
+                padding = children[i]->padding;
+                firstTerminal = children[i]->firstTerminal;
+            }
+            width += children[i]->width();
+        }
+        return arena_.create<Node>(symbol, state, firstTerminal, padding, width - padding,
+                                   static_cast<uint32_t>(count), reusable, uint8_t{0}, false, children);
+    }
+
+    // 复制子节点并在其后写入累计终点(见IncrementalNode::childEnds)
+    Node** makeIndexedChildren(Node* const* items, size_t count) {
+        if (count == 0) return nullptr;
+        Node** children = static_cast<Node**>(arena_.allocate(count * (sizeof(Node*) + sizeof(uint32_t)),
+                                                              alignof(Node*)));
+        uint32_t* ends = reinterpret_cast<uint32_t*>(children + count);
+        uint32_t end = 0;
+        for (size_t i = 0; i < count; ++i) {
+            children[i] = items[i];
+            end += items[i]->width();
+            ends[i] = end;
+        }
+        return children;
+    }
+
+    // 把listItems_末尾同层的topRun项封口为上一层的分块；与前面同层的项合并后再满则逐层进位
+    void closeRun(OpenList& open) {
+        const size_t count = open.topRun;
+        Node* const* items = listItems_.data() + listItems_.size() - count;
+        bool reusable = open.reusable;
+        for (size_t i = 0; i < count; ++i) reusable = reusable && items[i]->reusable;
+        Node* chunk = makeParent(open.list->symbol, items[0]->state, makeIndexedChildren(items, count), count, reusable);
+        chunk->level = static_cast<uint8_t>(items[0]->level + 1);
+        chunk->indexed = true;
+        listItems_.resize(listItems_.size() - count);
+
+        open.topRun = 1;
+        while (listItems_.size() - open.base >= open.topRun &&
+               listItems_[listItems_.size() - open.topRun]->level == chunk->level) {
+            open.topRun++;
+        }
+        listItems_.push_back(chunk);
+        if (open.topRun == kListChunk) closeRun(open);
+    }
+
+    // 向栈顶的列表追加一个元素(level为0)或整个分块
+    void appendToList(OpenList& open, Node* item, bool reusable) {
+        open.reusable = open.reusable && reusable;
+        // 先把末尾层数更低的项逐层封口，保持层数单调不增
+        while (listItems_.size() > open.base && listItems_.back()->level < item->level) closeRun(open);
+        if (listItems_.size() > open.base && listItems_.back()->level == item->level) {
+            open.topRun++;
+        } else {
+            open.topRun = 1;
+        }
+        listItems_.push_back(item);
+        if (open.topRun == kListChunk) closeRun(open);
+    }
+
+    // 开始构造位于分析栈nodes[depth]的列表：新建的列表没有元素，已有的列表(整体复用后又要追加)沿用其子节点
+    void openList(Node* list, size_t depth) {
+        openLists_.push_back({list, depth, listItems_.size(), 0, list->reusable});
+        for (uint32_t i = 0; i < list->childCount; ++i) {
+            appendToList(openLists_.back(), list->children[i], true);
+        }
+    }
+
+    // 列表被归约、错误恢复或接受取走之前封口：各层的项合并为一层，作为列表节点的子节点
+    void finishList(vector<Node*>& nodes) {
+        OpenList& open = openLists_.back();
+        while (listItems_.size() - open.base > open.topRun) closeRun(open);
+        const size_t count = listItems_.size() - open.base;
+        Node** children = makeIndexedChildren(listItems_.data() + open.base, count);
+        Node* list = makeParent(open.list->symbol, open.list->state, children, count, open.reusable);
+        list->indexed = true;
+        nodes[open.depth] = list;
+        listItems_.resize(open.base);
+        openLists_.pop_back();
+    }
+
+    // 封口分析栈中位于depth及以上的列表
+    void finishListsFrom(size_t depth, vector<Node*>& nodes) {
+        while (!openLists_.empty() && openLists_.back().depth >= depth) finishList(nodes);
+    }
+
+    static bool isEmpty(const Node* node) { return node == nullptr || node->size == 0; }
+
+    // 第i个子节点(含前导空白)相对于父节点起点的位置
+    static size_t childStart(Node* const* nodes, const uint32_t* ends, uint32_t i) {
+        if (ends != nullptr) return i == 0 ? 0 : ends[i - 1];
+        size_t start = 0;
+        for (uint32_t j = 0; j < i; ++j) {
+            if (nodes[j] != nullptr) start += nodes[j]->width();
+        }
+        return start;
+    }
+
+    // 最后一个在offset之前结束的Token的前导空白起点(没有则为0)：从这里重新切分，
+    // 该Token及其后一个字符都在编辑点之前，切分结果不变
+    size_t restartPosition(size_t offset) const {
+        Node* const top[2] = {root_, error_};
+        Node* const* nodes = top;
+        const uint32_t* ends = nullptr;
+        uint32_t count = 2;
+        size_t pos = 0;
+        size_t best = 0;
+        for (;;) {
+            // 第一个Token不在offset之前的第一个子节点：列表按累计终点二分，其余节点子节点很少，顺序查找
+            uint32_t end = 0;
+            if (ends != nullptr) {
+                uint32_t high = count;
+                while (end < high) {
+                    const uint32_t middle = end + (high - end) / 2;
+                    if (pos + childStart(nodes, ends, middle) + nodes[middle]->padding < offset) {
+                        end = middle + 1;
+                    } else {
+                        high = middle;
+                    }
+                }
+            } else {
+                for (size_t at = pos; end < count; ++end) {
+                    if (isEmpty(nodes[end])) continue;
+                    if (at + nodes[end]->padding >= offset) break;
+                    at += nodes[end]->width();
+                }
+            }
+
+            // 选出其前最后一个非空子树，以及再前一个非空子树
+            uint32_t chosen = end;
+            while (chosen > 0 && isEmpty(nodes[chosen - 1])) chosen--;
+            if (chosen-- == 0) return best;
+            uint32_t previous = chosen;
+            while (previous > 0 && isEmpty(nodes[previous - 1])) previous--;
+            if (previous != 0) {
+                best = lastTokenPosition(nodes[previous - 1], pos + childStart(nodes, ends, previous - 1));
+            }
+            const Node* node = nodes[chosen];
+            const size_t chosenPos = pos + childStart(nodes, ends, chosen);
+            if (node->childCount == 0) {
+                return chosenPos + node->width() < offset ? chosenPos : best;
+            }
+            nodes = node->children;
+            ends = node->indexed ? node->childEnds() : nullptr;
+            count = node->childCount;
+            pos = chosenPos;
+        }
+    }
+
+    // 子树最后一个Token的前导空白起点
+    static size_t lastTokenPosition(const Node* node, size_t pos) {
+        size_t end = pos + node->width();
+        while (node->childCount != 0) {
+            uint32_t i = node->childCount;
+            while (node->children[i - 1]->size == 0) --i;
+            node = node->children[i - 1];
+        }
+        return end - node->width();
+    }
+
+    // 旧树中起于start的叶子，同时给出其前导空白的起点
+    const Node* findLeaf(size_t start, size_t& paddingStart) const {
+        Node* const top[2] = {root_, error_};
+        Node* const* nodes = top;
+        const uint32_t* ends = nullptr;
+        uint32_t count = 2;
+        size_t pos = 0;
+        for (;;) {
+            const Node* found = nullptr;
+            if (ends != nullptr) {
+                // 列表及其分块：第一个累计终点在start之后的子节点
+                const uint32_t* it = upper_bound(ends, ends + count, static_cast<uint32_t>(start - pos));
+                if (it != ends + count) {
+                    found = nodes[it - ends];
+                    pos += it == ends ? 0 : it[-1];
+                }
+            } else {
+                for (uint32_t i = 0; i < count; ++i) {
+                    const Node* node = nodes[i];
+                    if (isEmpty(node)) continue;
+                    if (start < pos + node->width()) {
+                        found = node;
+                        break;
+                    }
+                    pos += node->width();
+                }
+            }
+            if (found == nullptr) return nullptr;
+            if (found->childCount == 0) {
+                if (pos + found->padding != start) return nullptr;
+                paddingStart = pos;
+                return found;
+            }
+            nodes = found->children;
+            ends = found->indexed ? found->childEnds() : nullptr;
+            count = found->childCount;
+        }
+    }
+
+    // 从region.prefixEnd起重新切分新文本，直到某个Token与旧树中编辑范围之后的叶子重合
+    void relex(EditRegion& region, size_t newEditEnd, size_t oldEditEnd) {
+        Lexer lexer{string_view(text_)};
+        lexer.restartAt(region.prefixEnd, 1);  // 行号只用于诊断，诊断时另行计算
+        size_t previousEnd = region.prefixEnd;
+        for (Token token = lexer.next(); token.kind != TK_END; token = lexer.next()) {
+            if (token.offset >= newEditEnd && root_ != nullptr) {
+                size_t paddingStart = 0;
+                const Node* leaf = findLeaf(token.offset - region.delta, paddingStart);
+                if (leaf != nullptr && leaf->size == token.length && paddingStart >= oldEditEnd &&
+                    paddingStart + region.delta == previousEnd) {
+                    region.suffixStart = paddingStart;
+                    return;
+                }
+            }
+            region.tokens.push_back(makeLeaf(token, previousEnd));
+            region.tokenPositions.push_back(previousEnd);
+            previousEnd = token.offset + token.length;
+        }
+    }
+
+    TableAction actionFor(int state, int terminal) const {
+        if (terminal == -1) return {ERROR, -1};
+        return unpackAction(grammar_->action(state, terminal));
+    }
+
+    void reduce(int prodId, vector<int>& states, vector<Node*>& nodes, bool reusable) {
+        const Production& prod = grammar_->production(prodId);
+        if (prod.rhs.size() > nodes.size()) {
+            throw runtime_error("Invalid parse table: reduction by " + prod.left + " underflows the stack");
+        }
+        const size_t length = prod.rhs.size();
+        const size_t base = nodes.size() - length;
+        finishListsFrom(prod.listAppend ? base + 1 : base, nodes);
+        if (prod.listAppend) {
+            // 列表L -> L X：X追加到栈顶正在构造的列表中，GOTO(L)仍是列表之上的状态，只需弹出X。
+            // 追加的一般是本次分析新建的列表；整体复用的列表之后的Token不变，不会再有元素追加进来，
+            // 万一追加也只是沿用其子节点重新开始构造，不修改旧树
+            if (openLists_.empty() || openLists_.back().depth != base) openList(nodes[base], base);
+            appendToList(openLists_.back(), nodes.back(), reusable);
+            nodes.pop_back();
+            states.pop_back();
+            stats_.reductions++;
+            return;
+        }
+
+        Node* node;
+        if (isList_[prod.lhs] && length <= 1) {
+            // 列表的起始产生式L -> ε或L -> X：压入占位节点，X作为第一个元素
+            node = arena_.create<Node>(prod.lhs, states[base], -1, 0u, 0u, 0u, reusable, uint8_t{0}, true, nullptr);
+            openList(node, base);
+            if (length == 1) appendToList(openLists_.back(), nodes[base], reusable);
+        } else {
+            Node** children = arena_.allocateArray<Node*>(length);
+            copy(nodes.begin() + base, nodes.end(), children);
+            node = makeParent(prod.lhs, states[base], children, length, reusable);
+        }
+        nodes.resize(base);
+        states.resize(base + 1);
+
+        int newState = grammar_->gotoState(states.back(), prod.lhs);
+        if (newState == -1) {
+            throw runtime_error("Missing GOTO entry for " + prod.left);
+        }
+        states.push_back(newState);
+        nodes.push_back(node);
+        stats_.reductions++;
+    }
+
+    // 以旧树和编辑区域为输入运行LR分析
+    void reparse(Node* oldRoot, Node* oldError, EditRegion& region) {
+        enum Phase { PREFIX, FRESH, SUFFIX, DONE };
+        TreeCursor cursor(oldRoot, oldError);
+        Phase phase = PREFIX;
+        size_t freshIndex = 0;
+
+        // 当前向前看子树及其(含前导空白)在新文本中的起点，输入结束时返回nullptr
+        auto peek = [&](size_t& pos) -> Node* {
+            for (;;) {
+                Node* node = phase == FRESH || phase == DONE ? nullptr : cursor.current();
+                switch (phase) {
+                    case PREFIX:
+                        if (node != nullptr && cursor.position() + node->width() <= region.prefixEnd) {
+                            pos = cursor.position();
+                            return node;
+                        }
+                        if (node != nullptr && cursor.position() < region.prefixEnd && node->childCount != 0) {
+                            cursor.descend();
+                        } else {
+                            phase = FRESH;
+                        }
+                        break;
+                    case FRESH:
+                        if (freshIndex < region.tokens.size()) {
+                            pos = region.tokenPositions[freshIndex];
+                            return region.tokens[freshIndex];
+                        }
+                        phase = SUFFIX;
+                        break;
+                    case SUFFIX:
+                        if (node == nullptr || region.suffixStart == NO_SUFFIX) {
+                            phase = DONE;
+                        } else if (cursor.position() >= region.suffixStart) {
+                            pos = cursor.position() + region.delta;
+                            return node;
+                        } else if (cursor.position() + node->width() <= region.suffixStart || node->childCount == 0) {
+                            cursor.skip();
+                        } else {
+                            cursor.descend();
+                        }
+                        break;
+                    case DONE:
+                        pos = text_.size();
+                        return nullptr;
+                }
+            }
+        };
+        auto consume = [&] {
+            if (phase == FRESH) freshIndex++;
+            else cursor.skip();
+        };
+
+        vector<int> states = {0};
+        vector<Node*> nodes;
+        bool recovered = false;
+        openLists_.clear();
+        listItems_.clear();
+        root_ = error_ = nullptr;
+        diagnostics_.clear();
+
+        for (;;) {
+            size_t pos = 0;
+            Node* lookahead = peek(pos);
+            const int terminal = lookahead != nullptr ? lookahead->firstTerminal : endTerminal_;
+            const TableAction action = actionFor(states.back(), terminal);
+
+            // 非终结符子树：先按其第一个终结符完成归约，再尝试整体压栈，不行就拆开
+            if (lookahead != nullptr && lookahead->childCount != 0) {
+                if (action.type == REDUCE) {
+                    reduce(action.value, states, nodes, !recovered);
+                    continue;
+                }
+                if (action.type == SHIFT && lookahead->reusable && lookahead->level != 0 &&
+                    lookahead->state == states.back() && !openLists_.empty() &&
+                    openLists_.back().depth + 1 == nodes.size() && nodes.back()->symbol == lookahead->symbol) {
+                    // 列表分块：栈顶是正在构造的同一列表，且状态与分块中第一个元素的进入状态相同，整体追加
+                    appendToList(openLists_.back(), lookahead, !recovered);
+                    consume();
+                    stats_.reusedSubtrees++;
+                    continue;
+                }
+                if (action.type == SHIFT && lookahead->reusable && lookahead->level == 0 && lookahead->symbol >= 0 &&
+                    lookahead->state == states.back()) {
+                    int newState = grammar_->gotoState(states.back(), lookahead->symbol);
+                    if (newState != -1) {
+                        states.push_back(newState);
+                        nodes.push_back(lookahead);
+                        consume();
+                        stats_.reusedSubtrees++;
+                        continue;
+                    }
+                }
+                cursor.descend();
+                continue;
+            }
+
+            switch (action.type) {
+                case SHIFT: {
+                    // 旧叶子的进入状态不同时复制一份，旧树保持不变
+                    Node* leaf = lookahead;
+                    if (leaf->state != states.back()) {
+                        leaf = arena_.create<Node>(*lookahead);
+                        leaf->state = states.back();
+                    }
+                    states.push_back(action.value);
+                    nodes.push_back(leaf);
+                    consume();
+                    stats_.shiftedTokens++;
+                    break;
+                }
+                case REDUCE:
+                    reduce(action.value, states, nodes, !recovered);
+                    break;
+                case ACCEPT:
+                    if (nodes.size() != 1) {
+                        throw runtime_error("Invalid parse result");
+                    }
+                    finishListsFrom(0, nodes);
+                    root_ = nodes.back();
+                    return;
+                case ERROR:
+                default: {
+                    reportError(lookahead, pos);
+
+                    // 与SyntaxParser相同的恐慌模式恢复：跳过其余输入，弹栈直到某个状态可以接受输入结束。
+                    // 丢弃的内容收进错误节点，保证树覆盖全部文本，修正错误后其中的子树仍可复用
+                    vector<Node*> skipped;
+                    while (Node* node = peek(pos)) {
+                        skipped.push_back(node);
+                        consume();
+                    }
+                    size_t keep = nodes.size();
+                    while (!grammar_->canContinueWith(states.data(), states.size(), endTerminal_)) {
+                        if (states.size() == 1) throw runtime_error("Fatal parsing error: recovery failed");
+                        states.pop_back();
+                        keep--;
+                    }
+                    finishListsFrom(keep, nodes);
+                    const size_t count = nodes.size() - keep + skipped.size();
+                    if (count != 0) {
+                        Node** children = arena_.allocateArray<Node*>(count);
+                        copy(skipped.begin(), skipped.end(), copy(nodes.begin() + keep, nodes.end(), children));
+                        error_ = makeParent(-1, -1, children, count, false);
+                    }
+                    nodes.resize(keep);
+                    recovered = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    void reportError(const Node* token, size_t pos) {
+        const size_t start = token != nullptr ? pos + token->padding : text_.size();
+        string_view value = token != nullptr ? string_view(text_).substr(start, token->size) : string_view("$");
+        const uint32_t line = static_cast<uint32_t>(count(text_.begin(), text_.begin() + start, '\n') + 1);
+        diagnostics_.push_back({line, static_cast<uint32_t>(start), "unexpected token '" + string(value) + "'"});
+        SLR_LOG(TRACE_ERROR, "Syntax error at line " << line << ": unexpected token '" << value << "'");
+    }
+
+    // 丢弃旧树，从头切分并分析；同时释放旧树占用的Arena
+    void parseFromScratch() {
+        arena_ = Arena();
+        root_ = error_ = nullptr;
+        stats_ = IncrementalStats();
+        stats_.fullParse = true;
+        EditRegion region;
+        relex(region, 0, 0);
+        stats_.relexedTokens = region.tokens.size();
+        reparse(nullptr, nullptr, region);
+        compactedBytes_ = arena_.bytesAllocated();
+    }
+
+    SyntaxTreeNode* convert(const Node* node, size_t end, uint32_t& nextStart, Arena& arena) const {
+        if (node->childCount == 0) {
+            if (node->size == 0) {
+                // 错误恢复之后的空归约以输入结束为向前看符号
+                const uint32_t at = node->reusable ? nextStart : static_cast<uint32_t>(text_.size());
+                return arena.create<SyntaxTreeNode>(node->symbol, 0u, at, at, nullptr);
+            }
+            nextStart = static_cast<uint32_t>(end - node->size);
+            return arena.create<SyntaxTreeNode>(node->symbol, 0u, nextStart, static_cast<uint32_t>(end), nullptr);
+        }
+        // 列表展开分块，全部元素作为直接子节点
+        Node* const* items = node->children;
+        uint32_t count = node->childCount;
+        vector<Node*> elements;
+        if (node->indexed) {
+            collectElements(node, elements);
+            items = elements.data();
+            count = static_cast<uint32_t>(elements.size());
+        }
+        // 自右向左转换：空子树的区间取其后第一个Token的起点，与SyntaxParser的结果一致
+        SyntaxTreeNode** children = arena.allocateArray<SyntaxTreeNode*>(count);
+        for (uint32_t i = count; i-- > 0;) {
+            children[i] = convert(items[i], end, nextStart, arena);
+            end -= items[i]->width();
+        }
+        return arena.create<SyntaxTreeNode>(node->symbol, count, children[0]->begin, children[count - 1]->end,
+                                            children);
+    }
+
+    static void collectElements(const Node* node, vector<Node*>& elements) {
+        for (uint32_t i = 0; i < node->childCount; ++i) {
+            if (node->children[i]->level != 0) {
+                collectElements(node->children[i], elements);
+            } else {
+                elements.push_back(node->children[i]);
+            }
+        }
+    }
+
+public:
+    IncrementalParser(shared_ptr<const CompiledGrammar> grammar, string text)
+        : grammar_(move(grammar)), text_(move(text)), endTerminal_(grammar_->symbols()->find("$")) {
+        isList_.assign(grammar_->symbols()->size(), false);
+        for (const Production& prod : grammar_->productions()) {
+            if (prod.listAppend) isList_[prod.lhs] = true;
+        }
+        parseFromScratch();
+    }
+
+    // 把[offset, offset + removed)替换为inserted，然后增量重新分析
+    void edit(size_t offset, size_t removed, string_view inserted) {
+        if (offset > text_.size() || removed > text_.size() - offset) {
+            throw runtime_error("Edit range out of bounds");
+        }
+        EditRegion region;
+        region.prefixEnd = restartPosition(offset);
+        region.delta = static_cast<ptrdiff_t>(inserted.size()) - static_cast<ptrdiff_t>(removed);
+        text_.replace(offset, removed, inserted.data(), inserted.size());
+
+        // 旧节点越积越多时整体重建一次，使Arena大小与当前树保持同一量级
+        if (arena_.bytesAllocated() > 2 * compactedBytes_ + (1u << 20)) {
+            parseFromScratch();
+            return;
+        }
+
+        stats_ = IncrementalStats();
+        relex(region, offset + inserted.size(), offset + removed);
+        stats_.relexedTokens = region.tokens.size();
+        reparse(root_, error_, region);
+    }
+
+    const string& text() const { return text_; }
+    const IncrementalNode* root() const { return root_; }
+    const vector<ParseDiagnostic>& diagnostics() const { return diagnostics_; }
+    const IncrementalStats& lastStats() const { return stats_; }
+
+    // 转换为带绝对位置的普通语法树(与SyntaxParser::parse()的结果相同)，耗时与树的大小成正比
+    SyntaxTree toSyntaxTree() const {
+        auto source = make_shared<const string>(text_);
+        Arena arena;
+        SyntaxTreeNode* root = nullptr;
+        if (root_ != nullptr) {
+            // root_之后只可能是错误节点，其第一个Token紧随root_的最后一个Token
+            uint32_t nextStart = static_cast<uint32_t>(error_ != nullptr ? root_->width() + error_->padding : text_.size());
+            root = convert(root_, root_->width(), nextStart, arena);
+        }
+        return SyntaxTree(move(arena), root, grammar_->symbols(), *source, source);
+    }
+};
@@ -0,0 +1,204 @@
+#pragma once
+
+// 语法分析的输出接收器(sink)。SyntaxParser::parse(sink)在每次移进、归约时调用sink，
+// 分析栈上保存的是sink定义的Value，因此输出形式完全由sink决定：
+//
+//   using Value = ...;   // 分析栈上每个符号对应的值
+//   using Result = ...;  // 分析成功后的结果
+//   Value shift(const Token& token, int terminal);
+//   Value reduce(const Production& prod, Value* rhs, uint32_t lookaheadOffset);  // rhs为右部各符号的值(共prod.rhs.size()个)
+//   void discard(const Value& value);   // 错误恢复时值被弹出栈
+//   Result finish(Value root, const ParseOutputInfo& info);
+//
+// prod.listAppend为真时产生式形如L -> L X(由文法中的重复符号"X*"/"X+"展开得到，见expandRepetitions)：
+// rhs[0]是已有的列表，sink应把rhs[1]并入其中，使整个列表成为一个N叉节点，而不是随长度加深的链。
+//
+// 自定义sink可直接在reduce中执行语义动作(求值、建索引等)而不构造任何节点。
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "../lexer/lexer.cpp"
+#include "grammer.h"
+
+using namespace std;
+
+// 分析完成时sink可以取用的信息
+struct ParseOutputInfo {
+    string_view source;                      // 源代码文本
+    shared_ptr<const void> sourceOwner;      // 源代码缓冲区的所有者(可能为空)
+    shared_ptr<const SymbolTable> symbols;
+};
+
+// 源代码字节区间[begin, end)
+struct SourceSpan {
+    uint32_t begin;
+    uint32_t end;
+};
+
+// 右部各符号区间合并为左部区间，空产生式取向前看符号处的空区间
+template <typename Value, typename SpanOf>
+inline SourceSpan mergeSpans(const Value* rhs, size_t count, uint32_t lookaheadOffset, SpanOf spanOf) {
+    if (count == 0) return {lookaheadOffset, lookaheadOffset};
+    return {spanOf(rhs[0]).begin, spanOf(rhs[count - 1]).end};
+}
+
+// ---------------- 语法树 ----------------
+
+// 构建SyntaxTree：节点分配在Arena中，结果接管Arena
+class TreeSink {
+private:
+    Arena arena_;
+
+public:
+    using Value = SyntaxTreeNode*;
+    using Result = SyntaxTree;
+
+    Value shift(const Token& token, int terminal) {
+        return arena_.create<SyntaxTreeNode>(terminal, 0u, token.offset, token.offset + token.length, nullptr);
+    }
+
+    Value reduce(const Production& prod, Value* rhs, uint32_t lookaheadOffset) {
+        if (prod.listAppend) {
+            // 列表节点原地追加子节点，区间随之延伸到新元素的终点
+            SyntaxTreeNode* list = rhs[0];
+            list->children = arena_.appendToArray(list->children, list->childCount, rhs[1]);
+            if (list->childCount++ == 0) list->begin = rhs[1]->begin;
+            list->end = rhs[1]->end;
+            return list;
+        }
+        const uint32_t length = static_cast<uint32_t>(prod.rhs.size());
+        SyntaxTreeNode** children = arena_.allocateArray<SyntaxTreeNode*>(length);
+        copy(rhs, rhs + length, children);
+        SourceSpan span = mergeSpans(rhs, length, lookaheadOffset,
+                                     [](const SyntaxTreeNode* node) { return SourceSpan{node->begin, node->end}; });
+        return arena_.create<SyntaxTreeNode>(prod.lhs, length, span.begin, span.end, children);
+    }
+
+    // 被丢弃的节点留在Arena中，随语法树一并释放
+    void discard(const Value&) {}
+
+    Result finish(Value root, const ParseOutputInfo& info) {
+        return SyntaxTree(move(arena_), root, info.symbols, info.source, info.sourceOwner);
+    }
+};
+
+// ---------------- 扁平后序数组 ----------------
+
+// 后序排列的节点记录：每个节点的子树紧邻其前，按childCount即可还原结构
+struct FlatNode {
+    int32_t symbol;
+    uint32_t begin;
+    uint32_t end;
+    uint32_t childCount;
+};
+
+struct FlatTree {
+    vector<FlatNode> nodes;                  // 根节点在最后
+    shared_ptr<const SymbolTable> symbols;
+    string_view source;
+    shared_ptr<const void> sourceOwner;
+
+    string_view text(const FlatNode& node) const { return source.substr(node.begin, node.end - node.begin); }
+};
+
+class FlatSink {
+public:
+    // 栈上每个符号对应数组中的一段连续记录(即其子树)
+    struct Value {
+        uint32_t first;   // 子树的第一条记录
+        uint32_t root;    // 子树根记录(该段的最后一条)
+    };
+    using Result = FlatTree;
+
+    explicit FlatSink(size_t expectedNodes = 0) { nodes_.reserve(expectedNodes); }
+
+    Value shift(const Token& token, int terminal) {
+        const uint32_t index = static_cast<uint32_t>(nodes_.size());
+        nodes_.push_back({terminal, token.offset, token.offset + token.length, 0});
+        return {index, index};
+    }
+
+    Value reduce(const Production& prod, Value* rhs, uint32_t lookaheadOffset) {
+        if (prod.listAppend) {
+            // 把列表的根记录移到新元素的子树之后，新元素成为列表的最后一个子节点，仍是后序排列
+            FlatNode list = nodes_[rhs[0].root];
+            const FlatNode& item = nodes_[rhs[1].root];
+            if (list.childCount++ == 0) list.begin = item.begin;
+            list.end = item.end;
+            move(nodes_.begin() + rhs[1].first, nodes_.end(), nodes_.begin() + rhs[0].root);
+            nodes_.back() = list;
+            return {rhs[0].first, static_cast<uint32_t>(nodes_.size() - 1)};
+        }
+        const size_t length = prod.rhs.size();
+        const uint32_t index = static_cast<uint32_t>(nodes_.size());
+        SourceSpan span = mergeSpans(rhs, length, lookaheadOffset,
+                                     [this](const Value& v) { return SourceSpan{nodes_[v.root].begin, nodes_[v.root].end}; });
+        nodes_.push_back({prod.lhs, span.begin, span.end, static_cast<uint32_t>(length)});
+        return {length ? rhs[0].first : index, index};
+    }
+
+    // 被弹出的总是最后一段，直接截断
+    void discard(const Value& value) { nodes_.resize(value.first); }
+
+    Result finish(Value, const ParseOutputInfo& info) {
+        return {move(nodes_), info.symbols, info.source, info.sourceOwner};
+    }
+
+private:
+    vector<FlatNode> nodes_;
+};
+
+// ---------------- 事件流 ----------------
+
+// APPEND_EVENT：按L -> L X归约，把栈顶的X追加为其下方列表L的最后一个子节点
+enum ParseEventType { SHIFT_EVENT, REDUCE_EVENT, APPEND_EVENT };
+
+struct ParseEvent {
+    ParseEventType type;
+    int symbol;            // 移进的终结符或归约得到的非终结符
+    int production;        // 归约所用产生式，移进时为-1
+    uint32_t childCount;   // 归约时为右部长度，追加时为1
+    SourceSpan span;
+};
+
+// 每次移进/归约回调一次，不分配任何内存；结果为整个输入的区间
+template <typename Callback>
+class EventSink {
+private:
+    Callback callback_;
+
+public:
+    using Value = SourceSpan;
+    using Result = SourceSpan;
+
+    explicit EventSink(Callback callback) : callback_(move(callback)) {}
+
+    Value shift(const Token& token, int terminal) {
+        SourceSpan span{token.offset, token.offset + token.length};
+        callback_(ParseEvent{SHIFT_EVENT, terminal, -1, 0, span});
+        return span;
+    }
+
+    Value reduce(const Production& prod, Value* rhs, uint32_t lookaheadOffset) {
+        const size_t length = prod.rhs.size();
+        SourceSpan span = mergeSpans(rhs, length, lookaheadOffset, [](const SourceSpan& s) { return s; });
+        if (prod.listAppend) {
+            callback_(ParseEvent{APPEND_EVENT, prod.lhs, prod.id, 1, span});
+            return span;
+        }
+        callback_(ParseEvent{REDUCE_EVENT, prod.lhs, prod.id, static_cast<uint32_t>(length), span});
+        return span;
+    }
+
+    void discard(const Value&) {}
+
+    Result finish(Value root, const ParseOutputInfo&) { return root; }
+};
+
+template <typename Callback>
+inline EventSink<Callback> makeEventSink(Callback callback) {
+    return EventSink<Callback>(move(callback));
+}
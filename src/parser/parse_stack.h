@@ -0,0 +1,204 @@
+#pragma once
+
+// 分析栈：容量有上限的栈及可在多次分析间复用的栈组。
+//
+// 栈按需倍增到上限为止，超过上限时抛出ParseStackOverflow，而不是无限增长直到耗尽内存。
+// 栈组从ParseStackPool取用、用完归还，保留已增长的容量，批量分析时只有最初几次分析会分配内存；
+// 每个栈记录历史最大深度(高水位)，据此调整初始容量和上限。
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// 默认的分析栈深度上限；语句序列是左递归的列表，栈深度只随语句的嵌套层数增长
+static const size_t kDefaultMaxParseDepth = size_t(1) << 24;
+static const size_t kDefaultInitialParseDepth = 1024;
+
+// 分析栈超过深度上限
+class ParseStackOverflow : public runtime_error {
+private:
+    size_t limit_;
+
+public:
+    explicit ParseStackOverflow(size_t limit)
+        : runtime_error("Parse stack overflow: depth limit " + to_string(limit) + " exceeded"), limit_(limit) {}
+
+    size_t limit() const { return limit_; }
+};
+
+// 容量有上限的栈：元素连续存放，容量不足时倍增(不超过limit)，弹出不释放容量
+template <typename T>
+class BoundedStack {
+private:
+    unique_ptr<T[]> items_;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+    size_t limit_;
+    size_t highWater_ = 0;
+
+    void grow() {
+        if (capacity_ >= limit_) throw ParseStackOverflow(limit_);
+        const size_t capacity = min(limit_, max<size_t>(capacity_ * 2, 16));
+        unique_ptr<T[]> items(new T[capacity]);
+        move(items_.get(), items_.get() + size_, items.get());
+        items_ = move(items);
+        capacity_ = capacity;
+    }
+
+public:
+    explicit BoundedStack(size_t limit = kDefaultMaxParseDepth, size_t initialCapacity = 0) : limit_(limit) {
+        reserve(initialCapacity);
+    }
+
+    void reserve(size_t capacity) {
+        capacity = min(capacity, limit_);
+        if (capacity <= capacity_) return;
+        unique_ptr<T[]> items(new T[capacity]);
+        move(items_.get(), items_.get() + size_, items.get());
+        items_ = move(items);
+        capacity_ = capacity;
+    }
+
+    void push_back(T value) {
+        if (size_ == capacity_) grow();
+        items_[size_++] = move(value);
+        if (size_ > highWater_) highWater_ = size_;
+    }
+
+    // 弹出的元素重置为T()，及时释放其持有的资源
+    void pop_back() {
+        --size_;
+        if (!is_trivially_destructible<T>::value) items_[size_] = T();
+    }
+
+    // 只能缩小
+    void resize(size_t size) {
+        if (!is_trivially_destructible<T>::value) {
+            for (size_t i = size; i < size_; ++i) items_[i] = T();
+        }
+        size_ = size;
+    }
+
+    void clear() { resize(0); }
+
+    T& back() { return items_[size_ - 1]; }
+    const T& back() const { return items_[size_ - 1]; }
+    T& operator[](size_t i) { return items_[i]; }
+    const T& operator[](size_t i) const { return items_[i]; }
+    T* data() { return items_.get(); }
+    const T* data() const { return items_.get(); }
+    const T* begin() const { return items_.get(); }
+    const T* end() const { return items_.get() + size_; }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    size_t capacity() const { return capacity_; }
+    size_t limit() const { return limit_; }
+    size_t highWater() const { return highWater_; }
+    void resetHighWater() { highWater_ = size_; }
+};
+
+// 一次分析用到的三个栈：状态栈、符号栈与sink的值栈一一对应(状态栈底多一个初始状态)
+template <typename Value>
+struct ParseStacks {
+    BoundedStack<int> stateStack;
+    BoundedStack<int> symbolStack;
+    BoundedStack<Value> valueStack;
+
+    explicit ParseStacks(size_t maxDepth = kDefaultMaxParseDepth, size_t initialDepth = kDefaultInitialParseDepth)
+        : stateStack(maxDepth + 1, initialDepth + 1), symbolStack(maxDepth, initialDepth),
+          valueStack(maxDepth, initialDepth) {}
+
+    // 清空并压入初始状态，准备下一次分析
+    void reset() {
+        stateStack.clear();
+        stateStack.push_back(0);
+        symbolStack.clear();
+        valueStack.clear();
+        stateStack.resetHighWater();
+        symbolStack.resetHighWater();
+        valueStack.resetHighWater();
+    }
+
+    // 自上次reset以来的最大深度
+    size_t highWater() const { return symbolStack.highWater(); }
+};
+
+// 分析栈组的对象池(线程安全)：acquire取得一组栈，租约析构时归还
+template <typename Value>
+class ParseStackPool {
+private:
+    mutable mutex lock_;
+    vector<unique_ptr<ParseStacks<Value>>> free_;
+    size_t maxDepth_;
+    size_t initialDepth_;
+    size_t created_ = 0;
+    size_t highWater_ = 0;
+
+    void release(unique_ptr<ParseStacks<Value>> stacks) {
+        lock_guard<mutex> guard(lock_);
+        highWater_ = max(highWater_, stacks->highWater());
+        free_.push_back(move(stacks));
+    }
+
+public:
+    class Lease {
+    private:
+        ParseStackPool* pool_;
+        unique_ptr<ParseStacks<Value>> stacks_;
+
+    public:
+        Lease(ParseStackPool* pool, unique_ptr<ParseStacks<Value>> stacks) : pool_(pool), stacks_(move(stacks)) {}
+        Lease(Lease&&) = default;
+        Lease& operator=(Lease&&) = delete;
+        ~Lease() {
+            if (stacks_) pool_->release(move(stacks_));
+        }
+
+        ParseStacks<Value>& operator*() const { return *stacks_; }
+        ParseStacks<Value>* operator->() const { return stacks_.get(); }
+    };
+
+    explicit ParseStackPool(size_t maxDepth = kDefaultMaxParseDepth,
+                            size_t initialDepth = kDefaultInitialParseDepth)
+        : maxDepth_(maxDepth), initialDepth_(initialDepth) {}
+
+    ParseStackPool(const ParseStackPool&) = delete;
+    ParseStackPool& operator=(const ParseStackPool&) = delete;
+
+    Lease acquire() {
+        unique_ptr<ParseStacks<Value>> stacks;
+        {
+            lock_guard<mutex> guard(lock_);
+            if (!free_.empty()) {
+                stacks = move(free_.back());
+                free_.pop_back();
+            } else {
+                created_++;
+            }
+        }
+        if (!stacks) stacks = make_unique<ParseStacks<Value>>(maxDepth_, initialDepth_);
+        stacks->reset();
+        return Lease(this, move(stacks));
+    }
+
+    size_t maxDepth() const { return maxDepth_; }
+    // 共创建过的栈组数(即同时进行的分析数的峰值)
+    size_t created() const {
+        lock_guard<mutex> guard(lock_);
+        return created_;
+    }
+    // 已归还的栈组中出现过的最大深度
+    size_t highWater() const {
+        lock_guard<mutex> guard(lock_);
+        return highWater_;
+    }
+};
@@ -1,5 +1,12 @@
+#ifndef PARSER_CPP
+#define PARSER_CPP
+
 #include "../lexer/lexer.cpp"
 #include "../slr/slr.cpp"
+#include "../table/table_file.cpp"
+#include "parse_sink.h"
+#include "parse_stack.h"
+#include <algorithm>
 #include <memory>
 #include <vector>
 #include <unordered_map>
@@ -8,98 +15,174 @@
 
 using namespace std;
 
-class SyntaxParser {
+// 编译好的文法：分析表、产生式、符号表及Token种类到终结符的映射。
+// 构造完成后只读，可由任意多个分析器在多个线程中共享
+class CompiledGrammar {
 private:
-    // 分析表结构
-    struct AnalysisTables {
-        vector<unordered_map<string, TableAction>> action;
-        vector<unordered_map<string, int>> goto_;
-    };
-
-    AnalysisTables tables_;
+    // 分析表：稠密的ACTION/GOTO二维表，或其压缩形式(二者只保留其一)
+    TableFormat tableFormat_;
+    ParseTable tables_;
+    CompressedParseTable compressedTables_;
     vector<Production> productions_;
+    shared_ptr<const SymbolTable> symbols_;  // 与分析得到的语法树共享
+
+    // 词法单元种类到终结符ID的映射，-1表示文法中没有该终结符
+    vector<int> kindToTerminal_;
+
+public:
+    // 采用一份构造好(或从表文件加载)的分析数据
+    explicit CompiledGrammar(GrammarTables grammar, TableFormat format = DENSE_TABLE) : tableFormat_(format) {
+        symbols_ = make_shared<const SymbolTable>(move(grammar.symbols));
+        productions_ = move(grammar.productions);
+        if (tableFormat_ == COMPRESSED_TABLE) {
+            compressedTables_ = CompressedParseTable::compress(grammar.table);
+        } else {
+            tables_ = move(grammar.table);
+        }
+
+        kindToTerminal_.assign(TOKEN_KIND_COUNT, -1);
+        for (int kind = 0; kind < TOKEN_KIND_COUNT; ++kind) {
+            int id = symbols_->find(tokenKindSpelling(static_cast<TokenKind>(kind)));
+            if (id != -1 && symbols_->isTerminal(id)) kindToTerminal_[kind] = id;
+        }
+    }
+
+    TableFormat tableFormat() const { return tableFormat_; }
+    const shared_ptr<const SymbolTable>& symbols() const { return symbols_; }
+    const vector<Production>& productions() const { return productions_; }
+    const Production& production(int id) const { return productions_[id]; }
+    int numStates() const {
+        return tableFormat_ == COMPRESSED_TABLE ? compressedTables_.numStates : tables_.numStates;
+    }
+
+    // 将Token映射为终结符ID，未知符号返回-1
+    int terminalFor(const Token& token) const {
+        return kindToTerminal_[token.kind];
+    }
+
+    // 按当前使用的表格式查表
+    PackedAction action(int state, int terminal) const {
+        return tableFormat_ == COMPRESSED_TABLE ? compressedTables_.action(state, terminal)
+                                                : tables_.action(state, terminal);
+    }
+
+    int gotoState(int state, int nonTerminal) const {
+        return tableFormat_ == COMPRESSED_TABLE ? compressedTables_.gotoState(state, nonTerminal)
+                                                : tables_.gotoState(state, nonTerminal);
+    }
+
+    // 状态栈为stateStack[0, depth)时，terminal能否在若干次归约之后被移进或接受。
+    // SLR按FOLLOW集归约，栈顶状态对terminal有动作并不代表能继续分析，错误恢复时需模拟到底
+    bool canContinueWith(const int* stateStack, size_t depth, int terminal) const {
+        vector<int> pushed;  // 模拟归约压入的GOTO状态，不修改真实的栈
+        for (;;) {
+            const int state = pushed.empty() ? stateStack[depth - 1] : pushed.back();
+            const TableAction next = unpackAction(action(state, terminal));
+            if (next.type == SHIFT || next.type == ACCEPT) return true;
+            if (next.type != REDUCE) return false;
+
+            const Production& prod = productions_[next.value];
+            const size_t fromPushed = min(prod.rhs.size(), pushed.size());
+            pushed.resize(pushed.size() - fromPushed);
+            if (prod.rhs.size() - fromPushed >= depth) return false;
+            depth -= prod.rhs.size() - fromPushed;
+            const int target = gotoState(pushed.empty() ? stateStack[depth - 1] : pushed.back(), prod.lhs);
+            if (target == -1) return false;
+            pushed.push_back(target);
+        }
+    }
+};
+
+// 语法分析中报告的错误
+struct ParseDiagnostic {
+    uint32_t line;
+    uint32_t offset;
+    string message;
+};
+
+class SyntaxParser {
+private:
+    shared_ptr<const CompiledGrammar> grammar_;
     Lexer lexer_;
+    vector<ParseDiagnostic> diagnostics_;  // 最近一次分析的错误
+    size_t maxStackDepth_ = kDefaultMaxParseDepth;  // 不使用ParseStackPool时分析栈的深度上限
+    size_t stackHighWater_ = 0;            // 最近一次成功分析的最大栈深度
 
-    // 初始化文法产生式
-    void initializeProductions() {
-        productions_ = {
+public:
+    // 内置文法的产生式
+    static vector<Production> initializeProductions() {
+        return {
             // 增广文法
             {"S'", {"Program"}, 0},
             
             // Program产生式
             {"Program", {"Statements"}, 1},
-            {"Statements", {"Statement", "Statements"}, 2},
-            {"Statements", {"ε"}, 3},
+            // 语句序列：展开为左递归的列表，整个序列归约为一个Statements节点
+            {"Statements", {"Statement*"}, 2},
             
             // Statement产生式
-            {"Statement", {"DeclStmt"}, 4},
-            {"Statement", {"AssignStmt"}, 5},
-            {"Statement", {"IfStmt"}, 6}, 
-            {"Statement", {"WhileStmt"}, 7},
-            {"Statement", {"Compute"}, 8},
+            {"Statement", {"DeclStmt"}, 3},
+            {"Statement", {"AssignStmt"}, 4},
+            {"Statement", {"IfStmt"}, 5}, 
+            {"Statement", {"WhileStmt"}, 6},
+            {"Statement", {"Compute"}, 7},
             
             
             // DeclStmt产生式
-            {"DeclStmt", {"Type", "IDENTIFIER", ";"}, 9},
+            {"DeclStmt", {"Type", "IDENTIFIER", ";"}, 8},
             
             // AssignStmt产生式
-            {"AssignStmt", {"IDENTIFIER", "=", "NUMBER", ";"}, 10},
+            {"AssignStmt", {"IDENTIFIER", "=", "NUMBER", ";"}, 9},
 
-            {"Compute", {"IDENTIFIER", "=", "Expr", ";"}, 11},
+            {"Compute", {"IDENTIFIER", "=", "Expr", ";"}, 10},
             
             // IfStmt产生式
-            {"IfStmt", {"if", "(", "Expr", ")", "{", "Statements", "}", "ElsePart"}, 12},
-            {"ElsePart", {"else", "{", "Statements", "}"}, 13},
-            {"ElsePart", {"ε"}, 14}, 
+            {"IfStmt", {"if", "(", "Expr", ")", "{", "Statements", "}", "ElsePart"}, 11},
+            {"ElsePart", {"else", "{", "Statements", "}"}, 12},
+            {"ElsePart", {"ε"}, 13}, 
             
             // WhileStmt产生式
-            {"WhileStmt", {"while", "(", "Expr", ")", "{", "Statements", "}"}, 15},
+            {"WhileStmt", {"while", "(", "Expr", ")", "{", "Statements", "}"}, 14},
             
             // 表达式处理
-            {"Expr", {"IDENTIFIER", "OPERATOR", "NUMBER"}, 16},
+            {"Expr", {"IDENTIFIER", "OPERATOR", "NUMBER"}, 15},
 
             
             // OPERATOR
-            {"OPERATOR", {"+"}, 17},
-            {"OPERATOR", {"*"}, 18},
-            {"OPERATOR", {"<"}, 19},
-            {"OPERATOR", {">"}, 20},
+            {"OPERATOR", {"+"}, 16},
+            {"OPERATOR", {"*"}, 17},
+            {"OPERATOR", {"<"}, 18},
+            {"OPERATOR", {">"}, 19},
 
             
             // 类型声明
-            {"Type", {"int"}, 21},
-            {"Type", {"float"}, 22},
-            {"Type", {"bool"}, 23},
-            
-            // 语句块处理
-            {"Statements", {"StmtList"}, 24},        
-            {"StmtList", {"Statement"}, 25},
-            {"StmtList", {"Statement", "StmtList"}, 26}
+            {"Type", {"int"}, 20},
+            {"Type", {"float"}, 21},
+            {"Type", {"bool"}, 22}
         };
     }
     
 
-    // 构建SLR分析表
-    void buildSLRTable() {
-        // 确保这些参数正确初始化
-        auto nonTerms = getNonTerminals();
+    // 由内置文法构建SLR分析表
+    static GrammarTables buildSLRTable() {
+        auto productions = initializeProductions();
+        auto nonTerms = getNonTerminals(productions);
         auto terms = getTerminals();
         string startSymbol = "S'"; // 或你的文法起始符号
-        SLRParser slrParser(productions_, nonTerms, terms, startSymbol);
-        slrParser.buildSLRTable(tables_.action, tables_.goto_);
+        return buildGrammarTables(productions, nonTerms, terms, startSymbol);
     }
 
     // 获取非终结符集合
-    unordered_set<string> getNonTerminals() const {
+    static unordered_set<string> getNonTerminals(const vector<Production>& productions) {
         unordered_set<string> nonTerms;
-        for (const auto& prod : productions_) {
+        for (const auto& prod : productions) {
             nonTerms.insert(prod.left);
         }
         return nonTerms;
     }
 
     // 获取终结符集合
-    unordered_set<string> getTerminals() const {
+    static unordered_set<string> getTerminals() {
         return {
             // 标识符和字面量
             "IDENTIFIER", "NUMBER", "STRING", "$",
@@ -120,205 +203,226 @@ private:
         };
     }
 
-public:
-    explicit SyntaxParser(const Lexer& lexer) : lexer_(lexer) {
-        initializeProductions();
-        this->buildSLRTable();
+    // 由内置文法构建可共享的编译文法
+    static shared_ptr<const CompiledGrammar> compileGrammar(TableFormat format = DENSE_TABLE) {
+        return make_shared<const CompiledGrammar>(buildSLRTable(), format);
     }
 
-    // 执行语法分析
-    shared_ptr<SyntaxTreeNode> parse() {
-        ParseContext context;
-        context.tokens = lexer_.tokenize();
-        context.tokens.push_back(Token{$, "$", 0});  // 添加结束标记
-    
-        // 打印输入的Token流
-        cout << "=== Token Stream ===" << endl;
-        for (const auto& tok : context.tokens) {
-            cout << "[" << tok.type << " \"" << tok.value << "\" line:" << tok.line << "]" << endl;
-        }
-        cout << "====================" << endl;
+    explicit SyntaxParser(const Lexer& lexer, TableFormat format = DENSE_TABLE)
+        : grammar_(compileGrammar(format)), lexer_(lexer) {}
+
+    // 使用预先生成的分析表(如loadTableFile映射的表文件)，不再构造LR(0)项集族
+    SyntaxParser(const Lexer& lexer, GrammarTables grammar, TableFormat format = DENSE_TABLE)
+        : grammar_(make_shared<const CompiledGrammar>(move(grammar), format)), lexer_(lexer) {}
+
+    // 共享已编译的文法：构造分析器只需复制一个指针和词法分析器
+    SyntaxParser(shared_ptr<const CompiledGrammar> grammar, const Lexer& lexer)
+        : grammar_(move(grammar)), lexer_(lexer) {}
+
+    const SymbolTable& getSymbols() const { return *grammar_->symbols(); }
+    const shared_ptr<const CompiledGrammar>& grammar() const { return grammar_; }
+    const vector<ParseDiagnostic>& diagnostics() const { return diagnostics_; }
+    size_t stackHighWater() const { return stackHighWater_; }
+
+    // 分析栈深度上限，超过时抛出ParseStackOverflow(使用ParseStackPool时以池的上限为准)
+    void setMaxStackDepth(size_t depth) { maxStackDepth_ = depth; }
+
+    // 执行语法分析，构建语法树
+    SyntaxTree parse() {
+        TreeSink sink;
+        return parse(sink);
+    }
+
+    // 使用池中的分析栈构建语法树
+    SyntaxTree parse(ParseStackPool<TreeSink::Value>& pool) {
+        TreeSink sink;
+        return parse(sink, pool);
+    }
+
+    // 执行语法分析，移进/归约结果交给sink处理(见parse_sink.h)
+    template <typename Sink>
+    typename Sink::Result parse(Sink& sink) {
+        ParseStacks<typename Sink::Value> stacks(maxStackDepth_);
+        stacks.reset();
+        return run(sink, stacks);
+    }
+
+    // 从池中取用分析栈，分析结束后归还，批量分析时不再为每次分析分配栈
+    template <typename Sink>
+    typename Sink::Result parse(Sink& sink, ParseStackPool<typename Sink::Value>& pool) {
+        auto stacks = pool.acquire();
+        return run(sink, *stacks);
+    }
+
+private:
+    template <typename Sink>
+    typename Sink::Result run(Sink& sink, ParseStacks<typename Sink::Value>& stacks) {
+        // 从词法分析器按需拉取Token，只保留一个向前看符号，不再物化整个Token序列
+        ParseContext<typename Sink::Value> context(lexer_, stacks);
+        diagnostics_.clear();
     
-        while (context.pos < context.tokens.size()) {
-            const Token& currentToken = context.tokens[context.pos];
-            const string& tokenValue = currentToken.value;
-            const TokenType& tokentype = currentToken.type;
+        for (;;) {
+            const Token& currentToken = context.lookahead;
             int currentState = context.currentState();
     
-            // 打印当前状态和输入符号
-            cout << "\nCurrent State: " << currentState 
-                 << ", Next Token: [" << currentToken.type
-                 << " \"" << tokenValue << "\"]" << endl;
-    
-            cout << "currentToken.type: " << currentToken.type << endl;
+            // 跟踪当前状态和输入符号
+            SLR_LOG(TRACE_VERBOSE, "\nCurrent State: " << currentState
+                                   << ", Next Token: [" << currentToken.type << " \"" << currentToken.value << "\"]");
             const TableAction action = getAction(currentState, currentToken);
     
             switch (action.type) {
                 case SHIFT: {
-                    performShift(action.value, tokenValue, context);
-                    // 打印移进后的状态栈和符号栈
-                    cout << "  ↪ SHIFT: push state " << action.value << endl;
-                    cout << "  State Stack: [ ";
-                    for (int s : context.stateStack) cout << s << " ";
-                    cout << "]" << endl;
-                    cout << "  Symbol Stack: [ ";
-                    for (const auto& node : context.symbolStack) cout << node->symbol << " ";
-                    cout << "]" << endl;
+                    performShift(action.value, tokenToTerminal(currentToken), context, sink);
+                    SLR_LOG(TRACE_VERBOSE, "  ↪ SHIFT: push state " << action.value);
+                    traceStacks(context);
                     break;
                 }
                 case REDUCE: {
-                    const Production& prod = productions_[action.value];
-                    cout << "  ↪ REDUCE: " << prod.left << " -> ";
-                    for (const auto& sym : prod.right) cout << sym << " ";
-                    cout << endl;
-                    performReduction(action.value, context);
-                    // 打印归约后的GOTO状态
-                    cout << "  ↪ GOTO[" << context.currentState() << ", " << prod.left << "] = "
-                         << context.currentState() << endl;
-                    cout << "  State Stack: [ ";
-                    for (int s : context.stateStack) cout << s << " ";
-                    cout << "]" << endl;
-                    cout << "  Symbol Stack: [ ";
-                    for (const auto& node : context.symbolStack) cout << node->symbol << " ";
-                    cout << "]" << endl;
+                    const Production& prod = grammar_->production(action.value);
+                    performReduction(action.value, context, sink);
+                    SLR_LOG(TRACE_VERBOSE, "  ↪ GOTO[" << prod.left << "] = " << context.currentState());
+                    traceStacks(context);
                     break;
                 }
                 case ACCEPT: {
-                    cout << "** ACCEPTED **" << endl;
-                    return finalizeParsing(context);
+                    SLR_LOG(TRACE_DEBUG, "** ACCEPTED **");
+                    return finalizeParsing(context, sink);
                 }
                 case ERROR:
                 default: {
-                    cerr << "  ↪ ERROR: No action defined for token \"" << tokenValue 
-                         << "\" in state " << currentState << endl;
-                    handleError(context);
+                    SLR_LOG(TRACE_VERBOSE, "  ↪ ERROR: No action defined for token \"" << currentToken.value
+                                           << "\" in state " << currentState);
+                    handleError(context, sink);
                     break;
                 }
             }
         }
-    
-        throw runtime_error("Unexpected end of input");
     }
 
-private:
-    // 解析上下文
+    // 解析上下文：词法分析器、向前看符号及(由调用者提供、可复用的)分析栈
+    template <typename Value>
     struct ParseContext {
-        vector<Token> tokens;
-        size_t pos = 0;
-        vector<int> stateStack = {0};
-        vector<shared_ptr<SyntaxTreeNode>> symbolStack;
+        Lexer lexer;        // 各次分析互不影响，词法分析器按值持有
+        Token lookahead;
+        ParseStacks<Value>& stacks;
+        BoundedStack<int>& stateStack;
+        BoundedStack<int>& symbolStack;
+        BoundedStack<Value>& valueStack;
+
+        ParseContext(const Lexer& source, ParseStacks<Value>& stacks)
+            : lexer(source), stacks(stacks), stateStack(stacks.stateStack), symbolStack(stacks.symbolStack),
+              valueStack(stacks.valueStack) {
+            advance();
+        }
+
+        // 消耗当前向前看符号并读入下一个
+        void advance() {
+            lookahead = lexer.next();
+            SLR_LOG(TRACE_VERBOSE, "[" << lookahead.type << " \"" << lookahead.value << "\" line:" << lookahead.line << "]");
+        }
 
         int currentState() const { return stateStack.back(); }
     };
 
-    // 在SyntaxParser类中添加以下成员函数
-    string tokenTypeToTerminal(const Token& token) const {
-        switch (token.type) {
-
-            // 关键字映射
-            case TokenType::KEYWORD:      return token.value;
-
-            // 运算符映射到文法定义名称
-            case TokenType::OPERATOR:     return token.value;
-
-            // 分隔符映射
-            case TokenType::DELIMITER:    return token.value;
-
-            // 字面量和特殊符号
-            case TokenType::IDENTIFIER:   return "IDENTIFIER";
-            case TokenType::NUMBER:       return "NUMBER";
-            case TokenType::STRING:       return "STRING";
-            case TokenType::$:            return "$";
-                
-            default:
-                return "UNKNOWN";
-        }
-    }
+    int tokenToTerminal(const Token& token) const { return grammar_->terminalFor(token); }
+    PackedAction lookupAction(int state, int terminal) const { return grammar_->action(state, terminal); }
+    int lookupGoto(int state, int nonTerminal) const { return grammar_->gotoState(state, nonTerminal); }
 
     // 获取当前动作
     TableAction getAction(int state, const Token& token) const {
-        string terminal = tokenTypeToTerminal(token);
-        cout << "Terminal: " << terminal << endl;
-        if (tables_.action[state].count(terminal)) {
-            return tables_.action[state].at(terminal);
-        }
+        int terminal = tokenToTerminal(token);
+        SLR_LOG(TRACE_VERBOSE, "Terminal: " << (terminal == -1 ? "UNKNOWN" : grammar_->symbols()->name(terminal)));
         // 处理未映射的符号（如未识别的运算符）
-        return {ERROR, -1};
+        if (terminal == -1) {
+            return {ERROR, -1};
+        }
+        return unpackAction(lookupAction(state, terminal));
     }
 
     // 执行移进动作
-    void performShift(int newState, const string& token, ParseContext& context) {
+    template <typename Value, typename Sink>
+    void performShift(int newState, int terminal, ParseContext<Value>& context, Sink& sink) {
+        // 先压符号栈：深度超限时由它按配置的上限报告(状态栈多一个栈底元素)
+        context.symbolStack.push_back(terminal);
         context.stateStack.push_back(newState);
-        context.symbolStack.push_back(
-            make_shared<SyntaxTreeNode>(token, context.tokens[context.pos].value));
-        context.pos++;
+        context.valueStack.push_back(sink.shift(context.lookahead, terminal));
+        context.advance();
     }
 
     // 执行归约动作
-    void performReduction(int prodId, ParseContext& context) {
-        const Production& prod = productions_[prodId];
-        auto node = make_shared<SyntaxTreeNode>(prod.left, "");
-
-        // 弹出右部符号
-        for (size_t i = 0; i < prod.right.size(); ++i) {
-            context.stateStack.pop_back();
-            node->children.insert(node->children.begin(), context.symbolStack.back());
-            context.symbolStack.pop_back();
+    template <typename Value, typename Sink>
+    void performReduction(int prodId, ParseContext<Value>& context, Sink& sink) {
+        const Production& prod = grammar_->production(prodId);
+        const size_t length = prod.rhs.size();
+        if (length > context.valueStack.size()) {
+            throw runtime_error("Invalid parse table: reduction by " + prod.left + " underflows the stack");
         }
 
+        // 值栈顶的length个元素恰好是按顺序排列的右部：整段交给sink，然后各栈截断一次
+        const size_t base = context.valueStack.size() - length;
+        Value value = sink.reduce(prod, context.valueStack.data() + base, context.lookahead.offset);
+        context.valueStack.resize(base);
+        context.symbolStack.resize(base);
+        context.stateStack.resize(context.stateStack.size() - length);
+
         // 处理GOTO
-        int newState = tables_.goto_[context.currentState()].at(prod.left);
+        int newState = lookupGoto(context.currentState(), prod.lhs);
+        if (newState == -1) {
+            throw runtime_error("Missing GOTO entry for " + prod.left);
+        }
+        context.symbolStack.push_back(prod.lhs);
         context.stateStack.push_back(newState);
-        context.symbolStack.push_back(node);
+        context.valueStack.push_back(move(value));
 
         logReduction(prod);
     }
 
     // 完成语法分析
-    shared_ptr<SyntaxTreeNode> finalizeParsing(ParseContext& context) {
-        if (context.symbolStack.size() != 1) {
+    template <typename Value, typename Sink>
+    typename Sink::Result finalizeParsing(ParseContext<Value>& context, Sink& sink) {
+        if (context.valueStack.size() != 1) {
             throw runtime_error("Invalid parse result");
         }
-        cout << "Parsing completed successfully!" << endl;
-        return context.symbolStack.back();
+        stackHighWater_ = context.stacks.highWater();
+        SLR_LOG(TRACE_INFO, "Parsing completed successfully! Max stack depth: " << stackHighWater_);
+        ParseOutputInfo info{context.lexer.sourceText(), context.lexer.sourceBuffer(), grammar_->symbols()};
+        return sink.finish(move(context.valueStack.back()), info);
     }
 
     // 错误处理
-    void handleError(ParseContext& context) {
-        const Token& errorToken = context.tokens[context.pos];
-        cerr << "Syntax error at line " << errorToken.line 
-             << ": unexpected token '" << errorToken.value << "'" << endl;
+    template <typename Value, typename Sink>
+    void handleError(ParseContext<Value>& context, Sink& sink) {
+        const Token& errorToken = context.lookahead;
+        diagnostics_.push_back({errorToken.line, errorToken.offset,
+                                "unexpected token '" + string(errorToken.value) + "'"});
+        SLR_LOG(TRACE_ERROR, "Syntax error at line " << errorToken.line
+                             << ": unexpected token '" << errorToken.value << "'");
 
         // 恐慌模式恢复
-        recoverFromError(context);
+        recoverFromError(context, sink);
     }
 
     // 错误恢复
-    void recoverFromError(ParseContext& context) {
-        static const set<string> syncSymbols = {"SEMICOLON", "$"};
+    template <typename Value, typename Sink>
+    void recoverFromError(ParseContext<Value>& context, Sink& sink) {
+        static const set<string, less<>> syncSymbols = {"SEMICOLON", "$"};
     
         // 查找最近的同步符号
-        while (context.pos < context.tokens.size() &&
-               syncSymbols.count(context.tokens[context.pos].value) == 0) {
-            context.pos++;
+        while (context.lookahead.kind != TK_END &&
+               syncSymbols.count(context.lookahead.value) == 0) {
+            context.advance();
         }
     
         // 弹出栈直到找到可继续分析的状态
         while (!context.stateStack.empty()) {
-            int currentState = context.currentState();
-            bool hasValidAction = false;
-    
-            // 检查当前状态是否有合法的同步符号动作
-            if (context.pos < context.tokens.size()) {
-                const string& token = context.tokens[context.pos].value;
-                hasValidAction = tables_.action[currentState].count(token) &&
-                                tables_.action[currentState][token].type != ERROR;
-            }
-    
-            if (hasValidAction) break;
+            // 检查当前栈能否(经若干次归约后)移进或接受同步符号
+            int terminal = tokenToTerminal(context.lookahead);
+            if (terminal != -1 && grammar_->canContinueWith(context.stateStack.data(), context.stateStack.size(), terminal)) break;
     
             context.stateStack.pop_back();
-            if (!context.symbolStack.empty()) {
+            if (!context.valueStack.empty()) {
+                sink.discard(context.valueStack.back());
+                context.valueStack.pop_back();
                 context.symbolStack.pop_back();
             }
         }
@@ -328,36 +432,19 @@ private:
         }
     }
 
-    // 检查有效动作
-    bool hasValidAction(int state, const string& token) const {
-        return tables_.action[state].count(token) && 
-               tables_.action[state].at(token).type != ERROR;
-    }
-
     // 记录归约操作
     void logReduction(const Production& prod) const {
-        cout << "Reduced by: " << prod.left << " -> ";
-        for (const auto& sym : prod.right) cout << sym << " ";
-        cout << endl;
+        SLR_LOG(TRACE_VERBOSE, "  ↪ REDUCE: " << prod.left << " -> " << traceJoin(prod.right));
     }
-};
 
-// 打印语法树
-inline void printSyntaxTree(const shared_ptr<SyntaxTreeNode>& node, int depth = 0) {
-    if (!node) return;
-
-    // 缩进
-    for (int i = 0; i < depth; ++i) cout << "  ";
-
-    // 节点信息
-    cout << node->symbol;
-    if (!node->value.empty()) {
-        cout << " (" << node->value << ")";
+    // 跟踪输出状态栈和符号栈
+    template <typename Value>
+    void traceStacks(const ParseContext<Value>& context) const {
+        SLR_LOG(TRACE_VERBOSE, "  State Stack: [ " << traceJoin(context.stateStack) << "]");
+        SLR_LOG(TRACE_VERBOSE, "  Symbol Stack: [ "
+                               << traceJoin(context.symbolStack, [this](int symbol) -> const string& { return grammar_->symbols()->name(symbol); })
+                               << "]");
     }
-    cout << endl;
+};
 
-    // 递归打印子节点
-    for (const auto& child : node->children) {
-        printSyntaxTree(child, depth + 1);
-    }
-}
\ No newline at end of file
+#endif
@@ -0,0 +1,201 @@
+#pragma once
+
+// 单个大文件的并行分析：先快速扫描一遍源文本，在顶层语句边界(花括号深度为0处的";"或使深度回到0的"}"，
+// 其后紧跟else时除外)把输入切成若干段，各段在线程池中从初始状态独立分析为Program，
+// 再把各段顶层Statements列表的子节点依次连接，拼成与整体分析完全相同的一棵语法树。
+//
+// 切分点取在边界之后下一个Token的起点(边界后的空白和注释归前一段)：段尾结束符的偏移等于
+// 整体分析时该处向前看符号的偏移，空产生式(如ElsePart -> ε)得到的区间与整体分析一致。
+// 任意一段出现语法错误，或分析结果不是预期的形状时，退回整体顺序分析，错误诊断与恢复结果保持不变。
+
+#include <algorithm>
+#include <exception>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "parser.cpp"
+#include "thread_pool.h"
+
+using namespace std;
+
+// 一段输入：[begin, end)及begin处的行号
+struct SplitChunk {
+    size_t begin;
+    size_t end;
+    size_t line;
+};
+
+// 按顶层语句边界把source切成不短于minBytes的若干段(最后一段可能更短)。
+// 与词法分析器一致地跳过字符串和注释，花括号不配对时不切分
+inline vector<SplitChunk> findSplitPoints(string_view source, size_t minBytes) {
+    vector<SplitChunk> chunks;
+    SplitChunk current{0, 0, 1};
+    const size_t n = source.size();
+    size_t line = 1;
+    long depth = 0;
+    size_t i = 0;
+
+    // 从p起跳过空白和注释，返回下一个Token的起点(line随之更新)
+    auto skipTrivia = [&](size_t p) {
+        while (p < n) {
+            const char c = source[p];
+            if (c == '\n') {
+                line++;
+                p++;
+            } else if (kCharClass[static_cast<unsigned char>(c)] == CC_SPACE) {
+                p++;
+            } else if (c == '/' && p + 1 < n && source[p + 1] == '/') {
+                const size_t newline = source.find('\n', p + 2);
+                if (newline == string_view::npos) return n;
+                line++;
+                p = newline + 1;
+            } else if (c == '/' && p + 1 < n && source[p + 1] == '*') {
+                size_t close = source.find("*/", p + 2);
+                close = close == string_view::npos ? n : close + 2;
+                line += static_cast<size_t>(count(source.begin() + p, source.begin() + min(close, n), '\n'));
+                p = close;
+            } else {
+                break;
+            }
+        }
+        return p;
+    };
+
+    while (i < n) {
+        const char c = source[i];
+        switch (c) {
+            case '\n':
+                line++;
+                i++;
+                continue;
+            case '"':
+                // 字符串内的换行不计入行号(与词法分析器相同)
+                for (i++; i < n && source[i] != '"'; i++) {
+                    if (source[i] == '\\') i++;
+                }
+                i++;
+                continue;
+            case '/':
+                i = i + 1 < n && (source[i + 1] == '/' || source[i + 1] == '*') ? skipTrivia(i) : i + 1;
+                continue;
+            case '{':
+                depth++;
+                i++;
+                continue;
+            case '}':
+                if (--depth < 0) return {{0, n, 1}};
+                i++;
+                if (depth != 0) continue;
+                break;
+            case ';':
+                i++;
+                if (depth != 0) continue;
+                break;
+            default:
+                i++;
+                continue;
+        }
+
+        // 顶层语句边界。if语句的"}"之后可能还有else分支，不能在此切开
+        const size_t next = skipTrivia(i);
+        i = next;
+        const uint8_t after = next + 4 < n ? kCharClass[static_cast<unsigned char>(source[next + 4])] : uint8_t(CC_OTHER);
+        const bool elseFollows = source.compare(next, 4, "else") == 0 && after != CC_LETTER && after != CC_DIGIT;
+        if (c == '}' && elseFollows) continue;
+        if (next < n && next - current.begin >= minBytes) {
+            current.end = next;
+            chunks.push_back(current);
+            current = {next, 0, line};
+        }
+    }
+    if (depth != 0) return {{0, n, 1}};
+    current.end = n;
+    chunks.push_back(current);
+    return chunks;
+}
+
+// 把词法分析器的整个源文本切分后在线程池上并行分析，结果与SyntaxParser(grammar, lexer).parse()相同。
+// diagnostics非空时返回语法错误(此时为整体顺序分析的结果)；maxStackDepth同时限制各段和整体分析的栈深度
+inline SyntaxTree parseSplit(const shared_ptr<const CompiledGrammar>& grammar, const Lexer& lexer, ThreadPool& pool,
+                             vector<ParseDiagnostic>* diagnostics = nullptr,
+                             size_t maxStackDepth = kDefaultMaxParseDepth, size_t minChunkBytes = 256 * 1024) {
+    const string_view text = lexer.sourceText();
+    auto parseWhole = [&] {
+        SyntaxParser parser(grammar, lexer);
+        parser.setMaxStackDepth(maxStackDepth);
+        SyntaxTree tree = parser.parse();
+        if (diagnostics) *diagnostics = parser.diagnostics();
+        return tree;
+    };
+
+    if (pool.size() <= 1 || text.size() < 2 * minChunkBytes) return parseWhole();
+
+    // 段数取线程数的数倍，耗时不均时由工作窃取平衡负载
+    const size_t target = max(minChunkBytes, text.size() / (pool.size() * 4) + 1);
+    const vector<SplitChunk> chunks = findSplitPoints(text, target);
+    if (chunks.size() <= 1) return parseWhole();
+
+    const int programSymbol = grammar->symbols()->find("Program");
+    const int statementsSymbol = grammar->symbols()->find("Statements");
+
+    struct ChunkResult {
+        Arena arena;                      // 该段语法树的节点
+        SyntaxTreeNode* program = nullptr;
+        SyntaxTreeNode* statements = nullptr;
+        bool ok = false;
+    };
+    vector<ChunkResult> results(chunks.size());
+
+    parallelFor(&pool, chunks.size(), [&](size_t k) {
+        ChunkResult& result = results[k];
+        try {
+            // 词法分析器只看到到段尾为止的文本，Token偏移仍是整个文件中的偏移
+            Lexer chunkLexer(text.substr(0, chunks[k].end));
+            chunkLexer.restartAt(chunks[k].begin, chunks[k].line);
+            SyntaxParser parser(grammar, chunkLexer);
+            parser.setMaxStackDepth(maxStackDepth);
+            SyntaxTree tree = parser.parse();
+            if (!parser.diagnostics().empty()) return;
+
+            // 检查形状：Program只有一个子节点，即该段的顶层语句列表
+            SyntaxTreeNode* program = tree.release(result.arena);
+            if (program->symbol != programSymbol || program->childCount != 1) return;
+            if (program->children[0]->symbol != statementsSymbol) return;
+            result.program = program;
+            result.statements = program->children[0];
+            result.ok = true;
+        } catch (const exception&) {
+            // 交给整体分析报告
+        }
+    }, 1);
+
+    for (const ChunkResult& result : results) {
+        if (!result.ok) return parseWhole();
+    }
+
+    // 各段的顶层语句依次并入第一段的Statements节点，区间取第一条语句的起点到最后一条语句的终点
+    size_t total = 0;
+    for (const ChunkResult& result : results) total += result.statements->childCount;
+    Arena arena;
+    SyntaxTreeNode** children = arena.allocateArray<SyntaxTreeNode*>(total);
+    SyntaxTreeNode* statements = results.front().statements;
+    uint32_t count = 0;
+    for (const ChunkResult& result : results) {
+        const SyntaxTreeNode* part = result.statements;
+        if (part->childCount == 0) continue;
+        if (count == 0) statements->begin = part->begin;
+        copy(part->children, part->children + part->childCount, children + count);
+        count += part->childCount;
+        statements->end = part->end;
+    }
+    statements->children = children;
+    statements->childCount = count;
+
+    // 第一段的Program即整棵树的根
+    SyntaxTreeNode* root = results.front().program;
+    root->begin = statements->begin;
+    root->end = statements->end;
+    for (ChunkResult& result : results) arena.absorb(move(result.arena));
+    if (diagnostics) diagnostics->clear();
+    return SyntaxTree(move(arena), root, grammar->symbols(), text, lexer.sourceBuffer());
+}
@@ -0,0 +1,389 @@
+#pragma once
+
+// 分块输入的可恢复语法分析：输入按任意边界分块送入(如来自套接字或解压器)，分析器处理完块中
+// 所有完整的Token后挂起，下一块到达时从挂起处继续；只保留分析栈和末尾不完整的一段文本，
+// 不缓存整个输入。
+//
+// 块末尾的Token可能被下一块延长(标识符、数字、"="与"=="、未闭合的字符串或注释)，因此触及块末尾的
+// Token连同其前导空白留到下一块再切分；整个输入结束(finish)时才切分到底。
+//
+// 分析状态可以序列化(checkpoint)并在另一个分析器上恢复(restore)，长时间运行的任务可以定期保存进度。
+// 序列化要求sink的Value可以按字节复制(如EventSink的SourceSpan)；sink自身的状态由调用者负责保存。
+// 源文本分析后即被丢弃，sink收到的Token文本只在shift调用期间有效，
+// finish时ParseOutputInfo::source为空，因此不适合需要保留源文本的TreeSink/FlatSink。
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "parser.cpp"
+
+using namespace std;
+
+// 检查点格式(字节序与生成机器相同)：
+//   [StreamCheckpointHeader]
+//   [状态栈]   depth+1 个int32
+//   [符号栈]   depth 个int32
+//   [值栈]     depth 个Value(按字节复制)
+//   [未切分的文本] pendingBytes 字节
+//   [诊断]     每条：uint32 行号, uint32 偏移, uint32 消息长度, 消息字节
+// checksum为文件头之后全部内容的FNV-1a 64位哈希
+static const char kStreamMagic[8] = {'S', 'L', 'R', 'S', 'T', 'R', 'M', '\0'};
+static const uint32_t kStreamVersion = 1;
+
+struct StreamCheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t endianTag;
+    uint64_t grammarHash;     // 文法指纹，恢复时须与分析器的文法一致
+    uint32_t valueSize;       // sizeof(Sink::Value)
+    uint32_t skipping;        // 是否处于错误恢复中(丢弃剩余输入)
+    uint64_t depth;           // 符号栈深度
+    uint64_t consumedBytes;   // 已切分并分析的输入字节数
+    uint64_t line;            // 未切分文本起点处的行号
+    uint64_t pendingBytes;
+    uint64_t diagnosticCount;
+    uint64_t checksum;
+};
+
+// 文法指纹：符号名及产生式结构的哈希
+inline uint64_t grammarFingerprint(const CompiledGrammar& grammar) {
+    vector<char> bytes;
+    const SymbolTable& symbols = *grammar.symbols();
+    for (int sym = 0; sym < symbols.size(); ++sym) {
+        const string& name = symbols.name(sym);
+        appendRaw(bytes, static_cast<uint32_t>(name.size()));
+        bytes.insert(bytes.end(), name.begin(), name.end());
+    }
+    for (const Production& prod : grammar.productions()) {
+        appendRaw(bytes, static_cast<int32_t>(prod.lhs));
+        appendRaw(bytes, static_cast<uint32_t>(prod.listAppend));
+        appendRaw(bytes, static_cast<uint32_t>(prod.rhs.size()));
+        for (int sym : prod.rhs) appendRaw(bytes, static_cast<int32_t>(sym));
+    }
+    return fnv1a64(bytes.data(), bytes.size());
+}
+
+template <typename Sink>
+class StreamParser {
+private:
+    using Value = typename Sink::Value;
+
+    shared_ptr<const CompiledGrammar> grammar_;
+    Sink& sink_;
+    int endTerminal_;
+
+    // 有深度上限的分析栈，超过上限时抛出ParseStackOverflow
+    ParseStacks<Value> stacks_;
+    BoundedStack<int>& stateStack_ = stacks_.stateStack;
+    BoundedStack<int>& symbolStack_ = stacks_.symbolStack;
+    BoundedStack<Value>& valueStack_ = stacks_.valueStack;
+
+    string pending_;               // 尚未切分的输入(上一块末尾不完整的部分及之后送入的块)
+    uint64_t consumedBytes_ = 0;   // pending_之前的输入字节数
+    size_t line_ = 1;              // pending_起点处的行号
+    bool skipping_ = false;        // 出错后丢弃剩余输入，输入结束时再弹栈恢复
+    bool finished_ = false;
+    vector<ParseDiagnostic> diagnostics_;
+
+    // 切分pending_中的Token逐个分析；final为false时保留末尾可能不完整的Token
+    void consume(bool final) {
+        Lexer lexer{string_view(pending_)};
+        lexer.restartAt(0, line_);
+        size_t kept = pending_.size();
+        for (;;) {
+            const size_t start = lexer.position();
+            const size_t startLine = lexer.lineNumber();
+            Token token = lexer.next();
+            if (token.kind == TK_END) {
+                if (final) {
+                    line_ = token.line;
+                } else {
+                    // 末尾的空白或未闭合的注释
+                    kept = start;
+                    line_ = startLine;
+                }
+                break;
+            }
+            if (!final && token.offset + token.length >= pending_.size()) {
+                kept = start;
+                line_ = startLine;
+                break;
+            }
+            // Token的偏移改为在整个输入中的偏移(超过4GB后按uint32回绕)
+            token.offset = static_cast<uint32_t>(consumedBytes_ + token.offset);
+            push(token);
+        }
+        consumedBytes_ += kept;
+        pending_.erase(0, kept);
+    }
+
+    // 分析一个完整的Token：执行其之前的归约并移进它
+    void push(const Token& token) {
+        if (skipping_) return;
+        const int terminal = grammar_->terminalFor(token);
+        for (;;) {
+            const TableAction action = terminal == -1 ? TableAction{ERROR, -1}
+                                                      : unpackAction(grammar_->action(stateStack_.back(), terminal));
+            switch (action.type) {
+                case SHIFT:
+                    // 先压符号栈：深度超限时由它按配置的上限报告(状态栈多一个栈底元素)
+                    symbolStack_.push_back(terminal);
+                    stateStack_.push_back(action.value);
+                    valueStack_.push_back(sink_.shift(token, terminal));
+                    return;
+                case REDUCE:
+                    reduce(action.value, token.offset);
+                    break;
+                case ACCEPT:
+                case ERROR:
+                default:
+                    reportError(token);
+                    skipping_ = true;
+                    return;
+            }
+        }
+    }
+
+    void reduce(int prodId, uint32_t lookaheadOffset) {
+        const Production& prod = grammar_->production(prodId);
+        if (prod.rhs.size() > valueStack_.size()) {
+            throw runtime_error("Invalid parse table: reduction by " + prod.left + " underflows the stack");
+        }
+        const size_t base = valueStack_.size() - prod.rhs.size();
+        Value value = sink_.reduce(prod, valueStack_.data() + base, lookaheadOffset);
+        valueStack_.resize(base);
+        symbolStack_.resize(base);
+        stateStack_.resize(stateStack_.size() - prod.rhs.size());
+
+        const int newState = grammar_->gotoState(stateStack_.back(), prod.lhs);
+        if (newState == -1) {
+            throw runtime_error("Missing GOTO entry for " + prod.left);
+        }
+        symbolStack_.push_back(prod.lhs);
+        stateStack_.push_back(newState);
+        valueStack_.push_back(move(value));
+    }
+
+    // 与SyntaxParser相同的恐慌模式恢复：丢弃剩余输入，弹栈直到能接受输入结束
+    void reportError(const Token& token) {
+        diagnostics_.push_back({token.line, token.offset, "unexpected token '" + string(token.value) + "'"});
+        SLR_LOG(TRACE_ERROR, "Syntax error at line " << token.line << ": unexpected token '" << token.value << "'");
+        while (!grammar_->canContinueWith(stateStack_.data(), stateStack_.size(), endTerminal_)) {
+            stateStack_.pop_back();
+            if (stateStack_.empty()) {
+                throw runtime_error("Fatal parsing error: recovery failed");
+            }
+            sink_.discard(valueStack_.back());
+            valueStack_.pop_back();
+            symbolStack_.pop_back();
+        }
+    }
+
+    template <typename T>
+    static void readRaw(string_view data, size_t& offset, T* out, size_t count = 1) {
+        if (data.size() - offset < sizeof(T) * count) {
+            throw runtime_error("Invalid stream checkpoint: truncated");
+        }
+        if (count != 0) memcpy(out, data.data() + offset, sizeof(T) * count);
+        offset += sizeof(T) * count;
+    }
+
+    // 栈中的状态和符号此后直接作为ACTION/GOTO的下标，校验和正确也要逐项检查：
+    // 栈底为初始状态，每个状态都是其下方状态经对应符号的移进或GOTO转移
+    void validateStacks(const vector<int32_t>& states, const vector<int32_t>& symbols) const {
+        const SymbolTable& table = *grammar_->symbols();
+        const int numStates = grammar_->numStates();
+        if (states.size() != symbols.size() + 1 || states[0] != 0) {
+            throw runtime_error("Invalid stream checkpoint: stack does not start at the initial state");
+        }
+        for (size_t i = 0; i < symbols.size(); ++i) {
+            const int32_t symbol = symbols[i];
+            const int32_t state = states[i + 1];
+            if (symbol < 0 || symbol >= table.size() || state < 0 || state >= numStates) {
+                throw runtime_error("Invalid stream checkpoint: state or symbol out of range");
+            }
+            int expected = -1;
+            if (table.isTerminal(symbol)) {
+                const TableAction action = unpackAction(grammar_->action(states[i], symbol));
+                if (action.type == SHIFT) expected = action.value;
+            } else {
+                expected = grammar_->gotoState(states[i], symbol);
+            }
+            if (expected != state) {
+                throw runtime_error("Invalid stream checkpoint: stack is not a valid parse prefix");
+            }
+        }
+    }
+
+public:
+    StreamParser(shared_ptr<const CompiledGrammar> grammar, Sink& sink, size_t maxStackDepth = kDefaultMaxParseDepth)
+        : grammar_(move(grammar)), sink_(sink), endTerminal_(grammar_->symbols()->find("$")), stacks_(maxStackDepth) {
+        stacks_.reset();
+    }
+
+    StreamParser(const StreamParser&) = delete;
+    StreamParser& operator=(const StreamParser&) = delete;
+
+    const vector<ParseDiagnostic>& diagnostics() const { return diagnostics_; }
+    uint64_t consumedBytes() const { return consumedBytes_; }
+    size_t pendingBytes() const { return pending_.size(); }
+    size_t stackDepth() const { return symbolStack_.size(); }
+    size_t maxStackDepth() const { return symbolStack_.limit(); }
+    // 自构造(或最近一次restore)以来的最大栈深度
+    size_t stackHighWater() const { return stacks_.highWater(); }
+
+    // 送入下一块输入，分析其中所有完整的Token
+    void feed(string_view chunk) {
+        if (finished_) {
+            throw runtime_error("Stream parser already finished");
+        }
+        pending_.append(chunk.data(), chunk.size());
+        consume(false);
+    }
+
+    // 输入结束：分析剩余文本和结束符，返回sink的结果
+    typename Sink::Result finish() {
+        if (finished_) {
+            throw runtime_error("Stream parser already finished");
+        }
+        consume(true);
+        finished_ = true;
+
+        const uint32_t endOffset = static_cast<uint32_t>(consumedBytes_);
+        const Token end(TK_END, "$", line_, endOffset, 0);
+        for (;;) {
+            const TableAction action = unpackAction(grammar_->action(stateStack_.back(), endTerminal_));
+            if (action.type == ACCEPT) break;
+            if (action.type == REDUCE) {
+                reduce(action.value, endOffset);
+            } else {
+                reportError(end);
+            }
+        }
+        if (valueStack_.size() != 1) {
+            throw runtime_error("Invalid parse result");
+        }
+        SLR_LOG(TRACE_INFO, "Stream parsing completed! Max stack depth: " << stacks_.highWater());
+        ParseOutputInfo info{string_view(), nullptr, grammar_->symbols()};
+        return sink_.finish(move(valueStack_.back()), info);
+    }
+
+    // 序列化当前分析状态(不含sink自身的状态)
+    string checkpoint() const {
+        static_assert(is_trivially_copyable<Value>::value, "checkpoint requires a trivially copyable Sink::Value");
+        vector<char> out(sizeof(StreamCheckpointHeader), 0);
+
+        StreamCheckpointHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, kStreamMagic, sizeof(kStreamMagic));
+        header.version = kStreamVersion;
+        header.endianTag = kEndianTag;
+        header.grammarHash = grammarFingerprint(*grammar_);
+        header.valueSize = sizeof(Value);
+        header.skipping = skipping_;
+        header.depth = symbolStack_.size();
+        header.consumedBytes = consumedBytes_;
+        header.line = line_;
+        header.pendingBytes = pending_.size();
+        header.diagnosticCount = diagnostics_.size();
+
+        for (int state : stateStack_) appendRaw(out, static_cast<int32_t>(state));
+        for (int symbol : symbolStack_) appendRaw(out, static_cast<int32_t>(symbol));
+        for (const Value& value : valueStack_) appendRaw(out, value);
+        out.insert(out.end(), pending_.begin(), pending_.end());
+        for (const ParseDiagnostic& diag : diagnostics_) {
+            appendRaw(out, diag.line);
+            appendRaw(out, diag.offset);
+            appendRaw(out, static_cast<uint32_t>(diag.message.size()));
+            out.insert(out.end(), diag.message.begin(), diag.message.end());
+        }
+
+        header.checksum = fnv1a64(out.data() + sizeof(header), out.size() - sizeof(header));
+        memcpy(out.data(), &header, sizeof(header));
+        return string(out.data(), out.size());
+    }
+
+    // 从checkpoint()的结果恢复分析状态，之后可继续送入检查点之后的输入
+    void restore(string_view data) {
+        static_assert(is_trivially_copyable<Value>::value, "restore requires a trivially copyable Sink::Value");
+        StreamCheckpointHeader header;
+        if (data.size() < sizeof(header)) {
+            throw runtime_error("Invalid stream checkpoint: truncated header");
+        }
+        memcpy(&header, data.data(), sizeof(header));
+        if (memcmp(header.magic, kStreamMagic, sizeof(kStreamMagic)) != 0) {
+            throw runtime_error("Invalid stream checkpoint: bad magic");
+        }
+        if (header.version != kStreamVersion) {
+            throw runtime_error("Unsupported stream checkpoint version " + to_string(header.version));
+        }
+        if (header.endianTag != kEndianTag) {
+            throw runtime_error("Stream checkpoint was written with a different byte order");
+        }
+        if (header.grammarHash != grammarFingerprint(*grammar_) || header.valueSize != sizeof(Value)) {
+            throw runtime_error("Stream checkpoint was written for a different grammar or sink");
+        }
+        if (fnv1a64(data.data() + sizeof(header), data.size() - sizeof(header)) != header.checksum) {
+            throw runtime_error("Invalid stream checkpoint: checksum mismatch");
+        }
+
+        // 各段长度先与数据大小比较，避免按损坏的计数分配内存
+        const uint64_t depth = header.depth;
+        const uint64_t stackBytes = (depth + 1) * sizeof(int32_t) + depth * (sizeof(int32_t) + sizeof(Value));
+        if (depth > symbolStack_.limit()) {
+            throw ParseStackOverflow(symbolStack_.limit());
+        }
+        if (depth >= data.size() || stackBytes + header.pendingBytes > data.size() - sizeof(header)) {
+            throw runtime_error("Invalid stream checkpoint: inconsistent layout");
+        }
+
+        size_t offset = sizeof(header);
+        vector<int32_t> states(depth + 1), symbols(depth);
+        vector<Value> values(depth);
+        readRaw(data, offset, states.data(), states.size());
+        readRaw(data, offset, symbols.data(), symbols.size());
+        readRaw(data, offset, values.data(), values.size());
+        validateStacks(states, symbols);
+        string pending(data.substr(offset, header.pendingBytes));
+        offset += header.pendingBytes;
+
+        vector<ParseDiagnostic> diagnostics;
+        for (uint64_t i = 0; i < header.diagnosticCount; ++i) {
+            ParseDiagnostic diag;
+            uint32_t length;
+            readRaw(data, offset, &diag.line);
+            readRaw(data, offset, &diag.offset);
+            readRaw(data, offset, &length);
+            if (data.size() - offset < length) {
+                throw runtime_error("Invalid stream checkpoint: truncated diagnostic");
+            }
+            diag.message.assign(data.data() + offset, length);
+            offset += length;
+            diagnostics.push_back(move(diag));
+        }
+        if (offset != data.size()) {
+            throw runtime_error("Invalid stream checkpoint: trailing data");
+        }
+
+        stateStack_.clear();
+        symbolStack_.clear();
+        valueStack_.clear();
+        stateStack_.resetHighWater();
+        symbolStack_.resetHighWater();
+        valueStack_.resetHighWater();
+        for (int32_t state : states) stateStack_.push_back(state);
+        for (int32_t symbol : symbols) symbolStack_.push_back(symbol);
+        for (Value& value : values) valueStack_.push_back(move(value));
+        pending_ = move(pending);
+        consumedBytes_ = header.consumedBytes;
+        line_ = static_cast<size_t>(header.line);
+        skipping_ = header.skipping != 0;
+        finished_ = false;
+        diagnostics_ = move(diagnostics);
+    }
+};
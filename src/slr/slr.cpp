@@ -6,331 +6,367 @@
 #include <string>
 #include <memory>
 #include <fstream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include "dense_bitset.h"
 #include "grammer.h"
+#include "parse_table.h"
+#include "thread_pool.h"
+#include "trace.h"
 
 using namespace std;
 
-inline void printTables(const vector<unordered_map<string, TableAction>>& actionTable,
-    const vector<unordered_map<string, int>>& gotoTable,
-    const string& filename);
+// 展开产生式右部的重复符号："X*"表示零个或多个X，"X+"表示一个或多个X(X为文法中的符号，
+// 且"X*"/"X+"本身不是已有的终结符或非终结符)。列表一律改写为左递归：L -> ε(或L -> X) | L X，
+// 分析栈深度与列表长度无关；L -> L X标记为listAppend，由sink把X并入L的节点，整个列表为一个N叉节点。
+// 左部只有一条产生式且右部只是一个重复符号时(如Statements -> Statement*)直接把左部变为列表，
+// 其余位置的重复符号改为同名的新非终结符；列表非终结符只有这两条产生式，其子节点总是逐个追加得到。
+// 原产生式保持编号，新产生式依次编在最后，新非终结符加入nonTerminals
+inline vector<Production> expandRepetitions(const vector<Production>& prods, unordered_set<string>& nonTerminals,
+                                            const unordered_set<string>& terminals) {
+    vector<Production> expanded = prods;
+    unordered_map<string, size_t> alternatives;  // 左部 -> 产生式条数
+    for (const auto& prod : prods) alternatives[prod.left]++;
+
+    // 重复符号的元素符号，不是重复符号时返回空串
+    auto elementOf = [&](const string& sym) -> string {
+        if (sym.size() < 2 || (sym.back() != '*' && sym.back() != '+')) return "";
+        if (terminals.count(sym) != 0 || nonTerminals.count(sym) != 0) return "";
+        string element = sym.substr(0, sym.size() - 1);
+        return nonTerminals.count(element) != 0 || terminals.count(element) != 0 ? element : "";
+    };
+    // 列表的追加产生式list -> list element
+    auto addAppend = [&](const string& list, const string& element) {
+        expanded.emplace_back(list, vector<string>{list, element}, static_cast<int>(expanded.size()));
+        expanded.back().listAppend = true;
+    };
+
+    for (size_t i = 0; i < prods.size(); ++i) {
+        const vector<string>& right = prods[i].right;
+        if (right.size() == 1 && alternatives[prods[i].left] == 1) {
+            const string element = elementOf(right[0]);
+            if (!element.empty()) {
+                expanded[i].right = {right[0].back() == '*' ? "ε" : element};
+                addAppend(prods[i].left, element);
+                continue;
+            }
+        }
+        for (const string& sym : right) {
+            const string element = elementOf(sym);
+            if (element.empty()) continue;
+            nonTerminals.insert(sym);
+            expanded.emplace_back(sym, vector<string>{sym.back() == '*' ? "ε" : element},
+                                  static_cast<int>(expanded.size()));
+            addAppend(sym, element);
+        }
+    }
+    return expanded;
+}
 
 class SLRParser {
 private:
     vector<Production> productions;
-    unordered_set<string> nonTerminals;
-    unordered_set<string> terminals;
-    string startSymbol;
-    unordered_map<string, unordered_set<string>> firstSets;
-    unordered_map<string, unordered_set<string>> followSets;
+    SymbolTable symbols;
+    int startSymbol;
+    vector<bool> nullable;                  // 按符号ID索引：能否推导出空串
+    vector<DenseBitset> firstSets;          // 按符号ID索引，位号为终结符ID(不含ε，ε由nullable表示)
+    vector<DenseBitset> followSets;         // 按符号ID索引，位号为终结符ID
+    vector<vector<int>> productionsByLhs;   // 非终结符ID -> 以其为左部的产生式编号
+    vector<DenseBitset> closureOf;          // 非终结符ID -> 闭包中引入的产生式集合
+
+    // 为文法中出现的所有符号分配ID，并把产生式翻译为ID形式
+    void internSymbols(const unordered_set<string>& nts,
+                       const unordered_set<string>& terms,
+                       const string& start) {
+        // 排序后再编号，保证同一文法得到的ID(以及分析表)是确定的
+        vector<string> sortedTerms(terms.begin(), terms.end());
+        sort(sortedTerms.begin(), sortedTerms.end());
+        vector<string> sortedNts(nts.begin(), nts.end());
+        sort(sortedNts.begin(), sortedNts.end());
+
+        for (const auto& term : sortedTerms) symbols.intern(term, TERMINAL);
+        for (const auto& nt : sortedNts) symbols.intern(nt, NONTERMINAL);
+        startSymbol = symbols.find(start);
+
+        for (auto& prod : productions) {
+            prod.lhs = symbols.find(prod.left);
+            prod.rhs.clear();
+            for (const auto& sym : prod.right) {
+                // "ε"只是书写上的空串占位符，不作为符号进入产生式
+                if (sym == "ε") continue;
+                int id = symbols.find(sym);
+                if (id == -1) {
+                    throw runtime_error("Unknown grammar symbol: " + sym);
+                }
+                prod.rhs.push_back(id);
+            }
+        }
+    }
 
-    void initializeFirstSets() {
-        // 终结符的FIRST集是它自己
-        for (const auto& term : terminals) {
-            firstSets[term].insert(term);
+    // 计算可空性：每个产生式记录右部尚未确认可空的符号数，降为0时左部可空
+    void initializeNullable() {
+        nullable.assign(symbols.size(), false);
+        vector<size_t> remaining(productions.size());
+        vector<vector<int>> occurrences(symbols.size());  // 符号 -> 右部含该符号的产生式(按出现次数重复)
+        vector<int> worklist;
+
+        for (const auto& prod : productions) {
+            remaining[prod.id] = prod.rhs.size();
+            for (int symbol : prod.rhs) {
+                if (symbols.isNonTerminal(symbol)) occurrences[symbol].push_back(prod.id);
+            }
+            if (prod.rhs.empty() && !nullable[prod.lhs]) {
+                nullable[prod.lhs] = true;
+                worklist.push_back(prod.lhs);
+            }
         }
-        
-        // 非终结符的FIRST集初始为空
-        for (const auto& nt : nonTerminals) {
-            firstSets[nt] = {};
+
+        while (!worklist.empty()) {
+            int symbol = worklist.back();
+            worklist.pop_back();
+            for (int prodId : occurrences[symbol]) {
+                const int A = productions[prodId].lhs;
+                if (--remaining[prodId] == 0 && !nullable[A]) {
+                    nullable[A] = true;
+                    worklist.push_back(A);
+                }
+            }
         }
+    }
 
-        bool changed;
-        do {
-            changed = false;
-            for (const auto& prod : productions) {
-                const string& A = prod.left;
-                size_t originalSize = firstSets[A].size();
-
-                bool canDeriveEpsilon = true;
-                for (const auto& symbol : prod.right) {
-                    // 处理当前符号的FIRST集
-                    for (const auto& s : firstSets[symbol]) {
-                        if (s != "ε" && firstSets[A].insert(s).second) {
-                            changed = true;
-                        }
-                    }
+    // 工作表方式的不动点求解：edges[X]中的符号Y满足 sets[Y] ⊇ sets[X]
+    // 只有当某个集合发生变化时，才把它传播给依赖它的集合
+    static void propagate(vector<DenseBitset>& sets, const vector<vector<int>>& edges) {
+        vector<int> worklist;
+        vector<bool> queued(sets.size(), false);
+        for (size_t sym = 0; sym < sets.size(); ++sym) {
+            if (!edges[sym].empty() && sets[sym].any()) {
+                worklist.push_back(static_cast<int>(sym));
+                queued[sym] = true;
+            }
+        }
 
-                    // 若当前符号不能推导ε，则后续符号无需处理
-                    if (!firstSets[symbol].count("ε")) {
-                        canDeriveEpsilon = false;
-                        break;
-                    }
+        while (!worklist.empty()) {
+            int from = worklist.back();
+            worklist.pop_back();
+            queued[from] = false;
+            for (int to : edges[from]) {
+                if (sets[to].unionWith(sets[from]) && !queued[to]) {
+                    worklist.push_back(to);
+                    queued[to] = true;
                 }
+            }
+        }
+    }
 
-                // 若所有符号均可推导ε，则添加ε到FIRST(A)
-                if (canDeriveEpsilon && firstSets[A].insert("ε").second) {
-                    changed = true;
-                }
+    // 符号集合的文本形式(按ID顺序，空格分隔)，仅用于跟踪输出
+    string formatSet(const DenseBitset& set) const {
+        string text;
+        set.forEach([&](size_t s) { text += symbols.name(static_cast<int>(s)) + " "; });
+        return text;
+    }
 
-                if (canDeriveEpsilon && !firstSets[A].count("ε")) {
-                    firstSets[A].insert("ε");
-                    changed = true;
-                }
+    void initializeFirstSets() {
+        const size_t numTerminals = symbols.numTerminals();
+        firstSets.assign(symbols.size(), DenseBitset(numTerminals));
+        vector<vector<int>> edges(symbols.size());
 
-                if (firstSets[A].size() > originalSize) {
-                    changed = true;
-                }
+        // 终结符的FIRST集是它自己
+        for (int sym = 0; sym < symbols.size(); ++sym) {
+            if (symbols.isTerminal(sym)) {
+                firstSets[sym].set(sym);
             }
-        } while (changed);
-
-        // 打印FIRST集用于调试
-        cout << "\nFIRST Sets:\n";
-        for (const auto& nt : nonTerminals) {
-            cout << "  FIRST(" << nt << ") = { ";
-            for (const auto& s : firstSets[nt]) cout<< s << " ";
-            cout << "}\n";
         }
-    }
 
-    unordered_set<string> computeStringFirst(const vector<string>& symbols) {
-        unordered_set<string> result;
-        bool canDeriveEpsilon = true;
-    
-        for (const auto& symbol : symbols) {
-            // 添加当前符号的FIRST集（排除ε）
-            for (const auto& s : firstSets[symbol]) {
-                if (s != "ε") {
-                    result.insert(s);
+        // FIRST(A) ⊇ FIRST(X)，X为A的右部中可空前缀之后的第一个符号(含可空前缀中的每个符号)
+        for (const auto& prod : productions) {
+            for (int symbol : prod.rhs) {
+                if (symbols.isTerminal(symbol)) {
+                    firstSets[prod.lhs].set(symbol);
+                } else if (symbol != prod.lhs) {
+                    edges[symbol].push_back(prod.lhs);
                 }
-            }
-    
-            // 若当前符号不能推导ε，则后续符号无需处理
-            if (!firstSets[symbol].count("ε")) {
-                canDeriveEpsilon = false;
+                if (!nullable[symbol]) break;
             }
         }
-    
-        // 若所有符号均可推导ε，添加ε
-        if (canDeriveEpsilon) {
-            result.insert("ε");
+        propagate(firstSets, edges);
+
+        // 跟踪输出FIRST集
+        SLR_LOG(TRACE_DEBUG, "\nFIRST Sets:");
+        for (int nt = 0; nt < symbols.size(); ++nt) {
+            if (!symbols.isNonTerminal(nt)) continue;
+            SLR_LOG(TRACE_DEBUG, "  FIRST(" << symbols.name(nt) << ") = { " << formatSet(firstSets[nt])
+                                 << (nullable[nt] ? "ε " : "") << "}");
         }
-    
-        return result;
     }
 
     void initializeFollowSets() {
-        for (const auto& nt : nonTerminals) {
-            followSets[nt] = {};
-        }
-        followSets[startSymbol].insert("$");
-
-        bool changed;
-        do {
-            changed = false;
-            for (const auto& prod : productions) {
-                const string& A = prod.left;
-                const vector<string>& beta = prod.right;
-        
-                for (size_t i = 0; i < beta.size(); ++i) {
-                    const string& B = beta[i];
-                    if (!nonTerminals.count(B)) continue;
-        
-                    // 计算B的FOLLOW集
-                    unordered_set<string> firstOfRest;
-                    bool canDeriveEpsilon = true;
-                    for (size_t j = i + 1; j < beta.size(); ++j) {
-                        const string& symbol = beta[j];
-                        for (const auto& s : firstSets[symbol]) {
-                            if (s != "ε") {
-                                firstOfRest.insert(s);
-                            }
-                        }
-                        if (!firstSets[symbol].count("ε")) {
-                            canDeriveEpsilon = false;
-                            break;
-                        }
-                    }
-        
-                    // 添加firstOfRest到B的FOLLOW集
-                    for (const auto& s : firstOfRest) {
-                        if (followSets[B].insert(s).second) {
-                            changed = true;
-                        }
-                    }
-        
-                    // 若后续符号可推导ε，或B是最后一个符号，添加A的FOLLOW集
-                    if (canDeriveEpsilon || i == beta.size() - 1) {
-                        for (const auto& s : followSets[A]) {
-                            if (followSets[B].insert(s).second) {
-                                changed = true;
-                            }
-                        }
+        const size_t numTerminals = symbols.numTerminals();
+        followSets.assign(symbols.size(), DenseBitset(numTerminals));
+        vector<vector<int>> edges(symbols.size());
+        followSets[startSymbol].set(symbols.find("$"));
+
+        for (const auto& prod : productions) {
+            const int A = prod.lhs;
+            const vector<int>& beta = prod.rhs;
+
+            // 从右向左扫描，维护后缀的FIRST集及其可空性，避免为每次出现重建临时集合
+            DenseBitset firstOfRest(numTerminals);
+            bool restNullable = true;
+            for (size_t i = beta.size(); i-- > 0;) {
+                const int B = beta[i];
+                if (symbols.isNonTerminal(B)) {
+                    // FOLLOW(B) ⊇ FIRST(β)；若β可空，则 FOLLOW(B) ⊇ FOLLOW(A)
+                    followSets[B].unionWith(firstOfRest);
+                    if (restNullable && B != A) {
+                        edges[A].push_back(B);
                     }
                 }
+
+                if (nullable[B]) {
+                    firstOfRest.unionWith(firstSets[B]);
+                } else {
+                    firstOfRest = firstSets[B];
+                    restNullable = false;
+                }
             }
-        } while (changed);
+        }
+        propagate(followSets, edges);
 
-        cout << "\nFOLLOW Sets:\n";
-        for (const auto& nt : nonTerminals) {
-            cout << "  FOLLOW(" << nt << ") = { ";
-            for (const auto& s : followSets[nt]) cout<< s << " ";
-            cout << "}\n";
+        SLR_LOG(TRACE_DEBUG, "\nFOLLOW Sets:");
+        for (int nt = 0; nt < symbols.size(); ++nt) {
+            if (!symbols.isNonTerminal(nt)) continue;
+            SLR_LOG(TRACE_DEBUG, "  FOLLOW(" << symbols.name(nt) << ") = { " << formatSet(followSets[nt]) << "}");
         }
     }
 
 
-    vector<Item> closure(const vector<Item>& items) {
-        vector<Item> closureItems = items;
-        bool changed;
-        do {
-            changed = false;
-            vector<Item> newItems;
-    
-            for (const auto& item : closureItems) {
-                if (item.dotPos >= productions[item.prodId].right.size()) continue;
-    
-                const string& symbol = productions[item.prodId].right[item.dotPos];
-                if (!nonTerminals.count(symbol)) continue;
-    
-                // 处理非终结符后的所有产生式
-                for (const auto& prod : productions) {
-                    if (prod.left != symbol) continue;
-                
-                    Item newItem{prod.id, 0};
-    
-                    // 检查是否已存在相同项
-                    bool exists = false;
-                    for (const auto& ci : closureItems) {
-                        if (ci == newItem) {
-                            exists = true;
-                            break;
-                        }
-                    }
-                    if (!exists) {
-                        exists = find(newItems.begin(), newItems.end(), newItem) != newItems.end();
-                    }
-    
-                    if (!exists) {
-                        newItems.push_back(newItem);
-                        changed = true;
+    // 建立文法索引：每个非终结符的产生式列表，以及每个非终结符的闭包产生式位集
+    // closureOf[A]包含所有满足 项(p, 0) 属于 closure({X -> α . A β}) 的产生式p
+    void buildClosureIndex() {
+        productionsByLhs.assign(symbols.size(), {});
+        for (const auto& prod : productions) {
+            productionsByLhs[prod.lhs].push_back(prod.id);
+        }
+
+        closureOf.assign(symbols.size(), DenseBitset());
+        for (int nt = 0; nt < symbols.size(); ++nt) {
+            if (!symbols.isNonTerminal(nt)) continue;
+
+            DenseBitset prods(productions.size());
+            vector<bool> visited(symbols.size(), false);
+            vector<int> worklist = {nt};
+            visited[nt] = true;
+            while (!worklist.empty()) {
+                int A = worklist.back();
+                worklist.pop_back();
+                for (int prodId : productionsByLhs[A]) {
+                    prods.set(prodId);
+                    const auto& rhs = productions[prodId].rhs;
+                    if (!rhs.empty() && symbols.isNonTerminal(rhs[0]) && !visited[rhs[0]]) {
+                        visited[rhs[0]] = true;
+                        worklist.push_back(rhs[0]);
                     }
                 }
             }
-    
-            closureItems.insert(closureItems.end(), newItems.begin(), newItems.end());
-        } while (changed);
-    
+            closureOf[nt] = move(prods);
+        }
+    }
+
+    // 求核的闭包：合并核中每个圆点后非终结符的缓存位集，再按产生式编号展开为圆点在最左的项
+    vector<Item> closure(const vector<Item>& kernel) {
+        DenseBitset prods(productions.size());
+        for (const auto& item : kernel) {
+            const auto& rhs = productions[item.prodId].rhs;
+            if (item.dotPos < static_cast<int>(rhs.size()) && symbols.isNonTerminal(rhs[item.dotPos])) {
+                prods.unionWith(closureOf[rhs[item.dotPos]]);
+            }
+        }
+
+        // 核中已有的圆点在最左的项(仅初始项)不重复加入
+        for (const auto& item : kernel) {
+            if (item.dotPos == 0) prods.reset(item.prodId);
+        }
+
+        vector<Item> closureItems = kernel;
+        prods.forEach([&closureItems](size_t prodId) {
+            closureItems.emplace_back(static_cast<int>(prodId), 0);
+        });
         return closureItems;
     }
 
-    vector<Item> goTo(const vector<Item>& items, const string& symbol) {
-        vector<Item> nextItems;
+    // 计算项集在每个符号上的后继核(圆点右移后的项)，按符号ID有序
+    map<int, vector<Item>> successorKernels(const vector<Item>& items) {
+        map<int, vector<Item>> kernels;
         for (const auto& item : items) {
             const Production& prod = productions[item.prodId];
-            if (item.dotPos < prod.right.size() && prod.right[item.dotPos] == symbol) {
-                // 创建新项并计算闭包
-                Item newItem{item.prodId, item.dotPos + 1};
-                nextItems.push_back(newItem);
+            if (item.dotPos < static_cast<int>(prod.rhs.size())) {
+                kernels[prod.rhs[item.dotPos]].push_back(Item{item.prodId, item.dotPos + 1});
             }
         }
-        return closure(nextItems);  // 返回闭包后的项集
+        // 规范化：核内项排序后，同一个项集只有一种表示
+        for (auto& kv : kernels) {
+            sort(kv.second.begin(), kv.second.end());
+        }
+        return kernels;
     }
 
-    vector<vector<Item>> constructCanonicalCollection() {
-        vector<vector<Item>> canonicalCollection;
+    // 构造LR(0)项集规范族：按层(广度优先)扩展，每个状态以排序后的核作为键放入哈希表去重，
+    // 转移在发现时即记录，建表时无需再做goTo和查找。
+    // 每层中各状态的后继核、新状态的闭包在线程池中并行计算；去重和编号按状态编号、
+    // 符号ID的顺序串行进行，编号与逐个处理工作表完全一致，多线程下输出的分析表不变
+    CanonicalCollection constructCanonicalCollection(size_t threadCount) {
+        CanonicalCollection collection;
+        unordered_map<vector<Item>, int, ItemSetHash> stateIndex;
+
         // 初始化第一个项集
-        vector<Item> initialItems = {
+        vector<Item> initialKernel = {
             Item(0, 0),
         };
-        auto initialClosure = closure(initialItems);
-        // // 调试输出
-        // for (const auto& item : initialClosure) {
-        //     const Production& prod = productions[item.prodId];
-        //     cout << "Item: " << prod.left << " -> ";
-        //     for (size_t i = 0; i < prod.right.size(); ++i) {
-        //         if (i == item.dotPos) cout << ".";
-        //         cout << prod.right[i] << " ";
-        //     }
-        //     if (item.dotPos == prod.right.size()) cout << ".";
-        //     cout << ", Lookahead: { ";
-        //     for (const auto& s : item.lookahead) cout << s << " ";
-        //     cout << "}\n";
-        // }
-        canonicalCollection.push_back(initialClosure);
-    
-        bool changed;
-        int iteration = 0;
-        size_t last_size = 0;
-        size_t oldSize = 0;
-        do {
-            iteration++;
-            changed = false;
-            last_size = oldSize;
-            oldSize = canonicalCollection.size();
-            vector<vector<Item>> temp_canonicalCollection;
-
-            
-            for (size_t i = last_size; i < oldSize; ++i) {
-                const auto& items = canonicalCollection[i];
-                
-                unordered_set<string> symbols;
-                for (const auto& item : items) {
-                    const Production& prod = productions[item.prodId];
-                    if (item.dotPos < prod.right.size()) {
-                        string symbol = prod.right[item.dotPos];
-                        symbols.insert(symbol);
-                        
-                    }
-                }
+        stateIndex.emplace(initialKernel, 0);
+        collection.states.push_back(closure(initialKernel));
+        collection.transitions.emplace_back();
+
+        // 线程池在某层规模足够大时才创建，小文法不产生线程开销
+        const size_t minParallelLevel = 64;
+        unique_ptr<ThreadPool> pool;
+
+        size_t levelBegin = 0;
+        while (levelBegin < collection.states.size()) {
+            const size_t levelEnd = collection.states.size();
+            if (!pool && threadCount > 1 && levelEnd - levelBegin >= minParallelLevel) {
+                pool = make_unique<ThreadPool>(threadCount);
+            }
 
-                
-                for (const auto& symbol : symbols) {
-                    auto nextItems = goTo(items, symbol);
-                    if (!nextItems.empty()) {
-                        bool exists = false;
-                        for (const auto& existing : canonicalCollection) {
-                            if (existing == nextItems) {
-                                exists = true;
-                                break;
-                            }
-                        }
-
-                        for (const auto& existing : temp_canonicalCollection) {
-                            if (existing == nextItems) {
-                                exists = true;
-                                break;
-                            }
-                        }
-                        
-                        if (!exists) {
-                            temp_canonicalCollection.push_back(nextItems);
-                            changed = true;
-
-                            // 调试输出
-                            cerr << "Added new state with " << nextItems.size() << " items" << endl;
-                        }
-                    }
+            vector<map<int, vector<Item>>> kernels(levelEnd - levelBegin);
+            parallelFor(pool.get(), kernels.size(), [&](size_t k) {
+                kernels[k] = successorKernels(collection.states[levelBegin + k]);
+            });
+
+            vector<vector<Item>> newKernels;
+            for (size_t k = 0; k < kernels.size(); ++k) {
+                for (auto& kv : kernels[k]) {
+                    const int nextState = static_cast<int>(levelEnd + newKernels.size());
+                    auto inserted = stateIndex.emplace(kv.second, nextState);
+                    if (inserted.second) newKernels.push_back(move(kv.second));
+                    collection.transitions[levelBegin + k].emplace_back(kv.first, inserted.first->second);
                 }
             }
 
-            // 合并 temp_canonicalCollection 到 canonicalCollection
-            vector<vector<Item>> merged = canonicalCollection; // 复制原有项集
-            for (const auto& newItems : temp_canonicalCollection) {
-                bool exists = false;
-                // 检查 newItems 是否已存在于 merged 中
-                for (const auto& existingItems : merged) {
-                    if (existingItems == newItems) { // 直接比较项集
-                        exists = true;
-                        break;
-                    }
-                }
-                if (!exists) {
-                    merged.push_back(newItems);
-                    changed = true;
-                }
+            collection.states.resize(levelEnd + newKernels.size());
+            collection.transitions.resize(levelEnd + newKernels.size());
+            parallelFor(pool.get(), newKernels.size(), [&](size_t k) {
+                collection.states[levelEnd + k] = closure(newKernels[k]);
+            });
+            for (size_t state = levelEnd; state < collection.states.size(); ++state) {
+                SLR_LOG(TRACE_VERBOSE, "Added new state with " << collection.states[state].size() << " items");
             }
-            canonicalCollection = merged; // 更新规范族
-            
-            
-            // 输出调试信息
-            cerr << "Iteration " << iteration 
-                 << ", Canonical size: " << canonicalCollection.size() 
-                 << endl;
-
-            
-        } while (changed);
-    
-        return canonicalCollection;
+            levelBegin = levelEnd;
+        }
+
+        SLR_LOG(TRACE_INFO, "Canonical size: " << collection.states.size());
+        return collection;
     }
 
 
@@ -339,128 +375,143 @@ public:
              const unordered_set<string>& nts,
              const unordered_set<string>& terms,
              const string& start)
-        : productions(prods), nonTerminals(nts), terminals(terms), startSymbol(start) 
     {
+        unordered_set<string> nonTerminals = nts;
+        productions = expandRepetitions(prods, nonTerminals, terms);
+        internSymbols(nonTerminals, terms, start);
+        buildClosureIndex();
+        initializeNullable();
         initializeFirstSets();
         initializeFollowSets();
     }
 
-    void buildSLRTable(vector<unordered_map<string, TableAction>>& actionTable,
-                              vector<unordered_map<string, int>>& gotoTable) {
-    auto canonicalCollection = constructCanonicalCollection();
-    actionTable.resize(canonicalCollection.size());
-    gotoTable.resize(canonicalCollection.size());
+    const SymbolTable& getSymbols() const { return symbols; }
+    const vector<Production>& getProductions() const { return productions; }
+
+    // threadCount为构造规范族使用的线程数，结果与线程数无关
+    void buildSLRTable(ParseTable& table, size_t threadCount = thread::hardware_concurrency()) {
+    const CanonicalCollection collection = constructCanonicalCollection(threadCount);
+    const auto& canonicalCollection = collection.states;
+    int numNonTerminals = 0;
+    for (int sym = 0; sym < symbols.size(); ++sym) {
+        if (symbols.isNonTerminal(sym)) numNonTerminals++;
+    }
+    table.resize(static_cast<int>(canonicalCollection.size()), symbols.numTerminals(), numNonTerminals);
+    const int endSymbol = symbols.find("$");
 
     for (size_t i = 0; i < canonicalCollection.size(); ++i) {
         const auto& items = canonicalCollection[i];
-        unordered_map<string, TableAction>& actionRow = actionTable[i];
-        unordered_map<string, int>& gotoRow = gotoTable[i];
+        const int state = static_cast<int>(i);
 
         // 处理归约和接受动作
         for (const auto& item : items) {
             const Production& prod = productions[item.prodId];
-            if (item.dotPos == prod.right.size()) { // 归约项
-                if (prod.left == startSymbol) {
+            if (item.dotPos == static_cast<int>(prod.rhs.size())) { // 归约项
+                if (prod.lhs == startSymbol) {
                     // 接受动作（仅在$符号列）
-                    actionRow["$"] = {ActionType::ACCEPT, -1};
+                    table.setAction(state, endSymbol, packAction(ActionType::ACCEPT, -1));
                 } else {
                     // 归约动作：仅添加到FOLLOW集的符号列
-                    for (const auto& followSym : followSets[prod.left]) {
-                        actionRow[followSym] = {ActionType::REDUCE, prod.id};
-                    }
+                    // 归约-归约冲突时保留文法中靠前的产生式，结果与项的排列顺序无关
+                    followSets[prod.lhs].forEach([&](size_t followSym) {
+                        const int terminal = static_cast<int>(followSym);
+                        const TableAction existing = unpackAction(table.action(state, terminal));
+                        if (existing.type == ActionType::REDUCE && existing.value < prod.id) return;
+                        table.setAction(state, terminal, packAction(ActionType::REDUCE, prod.id));
+                    });
                 }
             }
         }
 
-        // 处理移进和GOTO
-        unordered_set<string> processedSymbols;
-        
-        for (const auto& item : items) {
-            const Production& prod = productions[item.prodId];
-            if (item.dotPos < prod.right.size()) {
-                const string& symbol = prod.right[item.dotPos];
-                if (processedSymbols.count(symbol)) continue; // 避免重复处理
-                processedSymbols.insert(symbol);
-
-                vector<Item> nextItems = goTo(items, symbol);
-                int nextState = getStateIndex(nextItems, canonicalCollection);
-                if (nextState == -1) continue;
-
-                if (terminals.count(symbol)) { // 移进动作
-                    actionRow[symbol] = {ActionType::SHIFT, nextState};
-                } else if (nonTerminals.count(symbol)) { // GOTO转移
-                    gotoRow[symbol] = nextState;
-                }
+        // 处理移进和GOTO：直接使用构造规范族时记录的转移
+        for (const auto& transition : collection.transitions[i]) {
+            const int symbol = transition.first;
+            const int nextState = transition.second;
+
+            if (symbols.isTerminal(symbol)) { // 移进动作
+                table.setAction(state, symbol, packAction(ActionType::SHIFT, nextState));
+            } else if (symbols.isNonTerminal(symbol)) { // GOTO转移
+                table.setGoto(state, symbol, nextState);
             }
         }
     }
 
-    printTables(actionTable, gotoTable, "../slr_table.txt");
 }
-
-    // 辅助函数：获取项集对应的状态编号
-    int getStateIndex(const vector<Item>& items,vector<vector<Item>> canonicalCollection) {
-        for (size_t i = 0; i < canonicalCollection.size(); ++i) {
-            if (canonicalCollection[i] == items) {
-                return i;
-            }
-        }
-        return -1;
-    }
 };
 
+// 由文法构造分析器运行所需的全部数据
+inline GrammarTables buildGrammarTables(const vector<Production>& prods,
+                                        const unordered_set<string>& nts,
+                                        const unordered_set<string>& terms,
+                                        const string& start,
+                                        size_t threadCount = thread::hardware_concurrency()) {
+    SLRParser slrParser(prods, nts, terms, start);
+    GrammarTables grammar;
+    slrParser.buildSLRTable(grammar.table, threadCount);
+    grammar.symbols = slrParser.getSymbols();
+    grammar.productions = slrParser.getProductions();
+    return grammar;
+}
+
 
 
-inline void printTables(const vector<unordered_map<string, TableAction>>& actionTable,
-                 const vector<unordered_map<string, int>>& gotoTable,
-                 const string& filename = "../slr_table.txt") {
+// 以制表符分隔的可读形式输出分析表，便于调试文法
+inline void printTables(const ParseTable& table,
+                 const SymbolTable& symbols,
+                 const string& filename) {
     ofstream file(filename);
     if (!file.is_open()) {
         cerr << "Error: Failed to open file " << filename << endl;
         return;
     }
 
-    // 分离动作符号（终结符）和转移符号（非终结符）
-    unordered_set<string> actionSymbols;
-    unordered_set<string> gotoSymbols;
+    // 分离动作符号（终结符）和转移符号（非终结符），只输出至少有一个表项的列
+    vector<int> actionSymbols;
+    vector<int> gotoSymbols;
 
     // 收集所有终结符（包括$）
-    for (const auto& row : actionTable) {
-        for (const auto& entry : row) {
-            actionSymbols.insert(entry.first);
+    for (int sym = 0; sym < table.numTerminals; ++sym) {
+        for (int state = 0; state < table.numStates; ++state) {
+            if (table.action(state, sym) != PACKED_ERROR) {
+                actionSymbols.push_back(sym);
+                break;
+            }
         }
     }
 
     // 收集所有非终结符
-    for (const auto& row : gotoTable) {
-        for (const auto& entry : row) {
-            gotoSymbols.insert(entry.first);
+    for (int sym = table.numTerminals; sym < table.numTerminals + table.numNonTerminals; ++sym) {
+        for (int state = 0; state < table.numStates; ++state) {
+            if (table.gotoState(state, sym) != -1) {
+                gotoSymbols.push_back(sym);
+                break;
+            }
         }
     }
 
-    // 排序符号
-    vector<string> sortedActionSymbols(actionSymbols.begin(), actionSymbols.end());
-    sort(sortedActionSymbols.begin(), sortedActionSymbols.end());
-    vector<string> sortedGotoSymbols(gotoSymbols.begin(), gotoSymbols.end());
-    sort(sortedGotoSymbols.begin(), sortedGotoSymbols.end());
+    // 按符号名排序
+    auto byName = [&symbols](int a, int b) { return symbols.name(a) < symbols.name(b); };
+    vector<int> sortedActionSymbols = actionSymbols;
+    sort(sortedActionSymbols.begin(), sortedActionSymbols.end(), byName);
+    vector<int> sortedGotoSymbols = gotoSymbols;
+    sort(sortedGotoSymbols.begin(), sortedGotoSymbols.end(), byName);
 
     // 输出表头：终结符 | 非终结符
     file << "State\t";
-    for (const auto& sym : sortedActionSymbols) file << sym << "\t";
+    for (int sym : sortedActionSymbols) file << symbols.name(sym) << "\t";
     file << "|\t";
-    for (const auto& sym : sortedGotoSymbols) file << sym << "\t";
+    for (int sym : sortedGotoSymbols) file << symbols.name(sym) << "\t";
     file << "\n";
 
     // 输出每个状态的行
-    for (size_t i = 0; i < actionTable.size(); ++i) {
+    for (int i = 0; i < table.numStates; ++i) {
         file << "State " << i << "\t";
         
         // 动作表部分（终结符）
-        for (const auto& sym : sortedActionSymbols) {
-            const auto& actionRow = actionTable[i];
-            auto it = actionRow.find(sym);
-            if (it != actionRow.end()) {
-                const auto& action = it->second;
+        for (int sym : sortedActionSymbols) {
+            PackedAction entry = table.action(i, sym);
+            if (entry != PACKED_ERROR) {
+                const TableAction action = unpackAction(entry);
                 switch (action.type) {
                     case ActionType::SHIFT:    file << "s" << action.value; break;
                     case ActionType::REDUCE:   file << "r" << action.value; break;
@@ -476,11 +527,10 @@ inline void printTables(const vector<unordered_map<string, TableAction>>& action
         file << "|\t"; // 分隔符
         
         // 转移表部分（非终结符）
-        for (const auto& sym : sortedGotoSymbols) {
-            const auto& gotoRow = gotoTable[i];
-            auto it = gotoRow.find(sym);
-            if (it != gotoRow.end()) {
-                file << it->second;
+        for (int sym : sortedGotoSymbols) {
+            int target = table.gotoState(i, sym);
+            if (target != -1) {
+                file << target;
             } else {
                 file << ""; // 空单元格
             }
@@ -0,0 +1,38 @@
+// 使用编译期分析表的分析器：不包含任何文法处理/建表代码
+// 分析表头文件slr_tables.h在构建时由tablegen --header生成
+#include "slr_tables.h"
+#include "static_parser.h"
+
+int main() {
+    cout << "Program started" << endl;
+
+    string code = R"(
+        int x;
+        x = 10;
+        float y;
+        y = 3.14;
+        
+        if (x > 5) {
+            y = y + 1.0;
+        } else {
+            while (y < 10.0) {
+                y = y * 2.0;
+            }
+        }
+    )";
+
+    Lexer lexer(code);
+
+    try {
+        StaticTreeActions<GeneratedTables> actions;
+        StaticParser<GeneratedTables, StaticTreeActions<GeneratedTables>> parser(actions);
+        SyntaxTree syntaxTree = actions.finish(parser.parse(lexer), lexer.sourceText());
+        cout << "Parsing completed successfully!" << endl;
+        cout << "\nSyntax Tree:" << endl;
+        printSyntaxTree(syntaxTree);
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../lexer/lexer.cpp"
+#include "grammer.h"
+#include "parse_table.h"
+
+using namespace std;
+
+// 编译期特化的LR驱动器
+// Tables为tablegen --header生成的结构体，提供constexpr的ACTION/GOTO表、产生式长度和左部ID；
+// Actions为语义动作策略，需提供：
+//   using Value = ...;
+//   Value shift(const Token& token, int terminal);
+//   template <int Prod> Value reduce(Value* rhs);   // rhs指向长度为Tables::kProdLength[Prod]的连续区间
+// 每个产生式的归约函数单独实例化，弹栈长度和左部都是编译期常量。
+// Tables::kProdListAppend[Prod]为真的产生式形如L -> L X，reduce应把rhs[1]并入列表rhs[0]
+template <typename Tables, typename Actions>
+class StaticParser {
+public:
+    using Value = typename Actions::Value;
+
+    explicit StaticParser(Actions& actions) : actions_(actions) {}
+
+    // 按Token种类映射终结符ID，未知符号返回-1
+    static int terminalFor(const Token& token) {
+        static const array<int, TOKEN_KIND_COUNT> table = makeKindTable();
+        return table[token.kind];
+    }
+
+    // 从词法分析器按需拉取Token进行分析(只保留一个向前看符号)，返回开始符号对应的语义值。
+    // 词法分析器按值复制，调用者的实例不受影响
+    Value parse(const Lexer& source) {
+        states_.assign(1, 0);
+        values_.clear();
+
+        Lexer lexer(source);
+        Token token = lexer.next();
+        for (;;) {
+            const int terminal = terminalFor(token);
+            const PackedAction entry = terminal == -1
+                ? PACKED_ERROR
+                : Tables::kAction[states_.back() * Tables::kNumTerminals + terminal];
+
+            actions_.setLookahead(token);
+            switch (entry & 3u) {
+                case PACKED_SHIFT:
+                    states_.push_back(static_cast<int>(entry >> 2));
+                    values_.push_back(actions_.shift(token, terminal));
+                    token = lexer.next();
+                    break;
+                case PACKED_REDUCE:
+                    reducers()[entry >> 2](*this);
+                    break;
+                case PACKED_ACCEPT:
+                    return move(values_.back());
+                default:
+                    throw runtime_error("Syntax error at line " + to_string(token.line) +
+                                        ": unexpected token '" + string(token.value) + "'");
+            }
+        }
+    }
+
+private:
+    using ReduceFn = void (*)(StaticParser&);
+
+    Actions& actions_;
+    vector<int> states_;
+    vector<Value> values_;
+
+    template <int Prod>
+    static void reduceProduction(StaticParser& self) {
+        constexpr int length = Tables::kProdLength[Prod];
+        constexpr int lhs = Tables::kProdLhs[Prod];
+
+        const size_t base = self.values_.size() - length;
+        Value value = self.actions_.template reduce<Prod>(self.values_.data() + base);
+        self.values_.resize(base);
+        self.states_.resize(self.states_.size() - length);
+
+        const int target = Tables::kGoto[self.states_.back() * Tables::kNumNonTerminals + (lhs - Tables::kNumTerminals)];
+        self.states_.push_back(target);
+        self.values_.push_back(move(value));
+    }
+
+    // 终结符按名字排序编号，每个Token种类的书写形式二分查找一次即可
+    static array<int, TOKEN_KIND_COUNT> makeKindTable() {
+        array<int, TOKEN_KIND_COUNT> table;
+        const char* const* begin = Tables::kSymbolNames;
+        const char* const* end = Tables::kSymbolNames + Tables::kNumTerminals;
+        for (int kind = 0; kind < TOKEN_KIND_COUNT; ++kind) {
+            const string_view spelling = tokenKindSpelling(static_cast<TokenKind>(kind));
+            auto it = lower_bound(begin, end, spelling,
+                                  [](const char* name, string_view text) { return text.compare(name) > 0; });
+            table[kind] = it != end && spelling == *it ? static_cast<int>(it - begin) : -1;
+        }
+        return table;
+    }
+
+    template <size_t... Prods>
+    static const ReduceFn* makeReducers(index_sequence<Prods...>) {
+        static const ReduceFn table[] = {&reduceProduction<static_cast<int>(Prods)>...};
+        return table;
+    }
+
+    static const ReduceFn* reducers() {
+        static const ReduceFn* table = makeReducers(make_index_sequence<Tables::kNumProductions>());
+        return table;
+    }
+};
+
+// 构建SyntaxTree语法树的语义动作：节点分配在Arena中，由finish()产生的SyntaxTree持有
+template <typename Tables>
+struct StaticTreeActions {
+    using Value = SyntaxTreeNode*;
+
+    Arena arena;
+    uint32_t lookaheadOffset = 0;
+
+    // 由生成的符号名构造的符号表，供语法树按ID取名
+    static const shared_ptr<const SymbolTable>& symbols() {
+        static const shared_ptr<const SymbolTable> table = [] {
+            auto symbols = make_shared<SymbolTable>();
+            for (int id = 0; id < Tables::kNumTerminals + Tables::kNumNonTerminals; ++id) {
+                symbols->intern(Tables::kSymbolNames[id], id < Tables::kNumTerminals ? TERMINAL : NONTERMINAL);
+            }
+            return shared_ptr<const SymbolTable>(move(symbols));
+        }();
+        return table;
+    }
+
+    void setLookahead(const Token& token) { lookaheadOffset = token.offset; }
+
+    Value shift(const Token& token, int terminal) {
+        return arena.create<SyntaxTreeNode>(terminal, 0u, token.offset, token.offset + token.length, nullptr);
+    }
+
+    template <int Prod>
+    Value reduce(Value* rhs) {
+        if constexpr (Tables::kProdListAppend[Prod]) {
+            // 列表节点原地追加子节点
+            SyntaxTreeNode* list = rhs[0];
+            list->children = arena.appendToArray(list->children, list->childCount, rhs[1]);
+            if (list->childCount++ == 0) list->begin = rhs[1]->begin;
+            list->end = rhs[1]->end;
+            return list;
+        }
+        constexpr int length = Tables::kProdLength[Prod];
+        SyntaxTreeNode** children = arena.allocateArray<SyntaxTreeNode*>(length);
+        copy(rhs, rhs + length, children);
+        const uint32_t begin = length ? rhs[0]->begin : lookaheadOffset;
+        const uint32_t end = length ? rhs[length - 1]->end : begin;
+        return arena.create<SyntaxTreeNode>(static_cast<int32_t>(Tables::kProdLhs[Prod]),
+                                            static_cast<uint32_t>(length), begin, end, children);
+    }
+
+    // 以分析结果构造语法树，Arena随之移交
+    SyntaxTree finish(Value root, string_view source, shared_ptr<const void> owner = nullptr) {
+        return SyntaxTree(move(arena), root, symbols(), source, move(owner));
+    }
+};
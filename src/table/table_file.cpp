@@ -0,0 +1,349 @@
+#ifndef TABLE_FILE_CPP
+#define TABLE_FILE_CPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "grammer.h"
+#include "mapped_file.h"
+#include "parse_table.h"
+
+using namespace std;
+
+// 二进制分析表文件格式(字节序与生成机器相同，由endianTag校验)：
+//   [文件头 TableFileHeader]
+//   [符号段]     每个符号：uint32 种类, uint32 名字长度, 名字字节；按符号ID顺序
+//   [产生式段]   每个产生式：int32 左部ID, uint32 标志, uint32 右部长度, int32 右部ID...；按产生式编号顺序
+//                标志位0为listAppend(列表的追加产生式L -> L X)
+//   [ACTION段]   numStates * actionStride 个PackedAction，64字节对齐
+//   [GOTO段]     numStates * gotoStride 个int32，64字节对齐
+// checksum为文件头之后全部内容的FNV-1a 64位哈希
+static const char kTableMagic[8] = {'S', 'L', 'R', 'T', 'A', 'B', 'L', 'E'};
+static const uint32_t kTableVersion = 2;
+static const uint32_t kEndianTag = 0x01020304;
+static const uint32_t kListAppendFlag = 1u;
+
+struct TableFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t endianTag;
+    uint32_t numSymbols;
+    uint32_t numProductions;
+    uint32_t numStates;
+    uint32_t numTerminals;
+    uint32_t numNonTerminals;
+    uint32_t actionStride;
+    uint32_t gotoStride;
+    uint32_t reserved;
+    uint64_t symbolsOffset;
+    uint64_t productionsOffset;
+    uint64_t actionOffset;
+    uint64_t gotoOffset;
+    uint64_t fileSize;
+    uint64_t checksum;
+};
+
+inline uint64_t fnv1a64(const char* data, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+template <typename T>
+inline void appendRaw(vector<char>& out, const T& value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+// 将分析表写为二进制文件
+inline void writeTableFile(const string& filename, const GrammarTables& grammar) {
+    const ParseTable& table = grammar.table;
+    vector<char> out(sizeof(TableFileHeader), 0);
+
+    TableFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kTableMagic, sizeof(kTableMagic));
+    header.version = kTableVersion;
+    header.endianTag = kEndianTag;
+    header.numSymbols = static_cast<uint32_t>(grammar.symbols.size());
+    header.numProductions = static_cast<uint32_t>(grammar.productions.size());
+    header.numStates = static_cast<uint32_t>(table.numStates);
+    header.numTerminals = static_cast<uint32_t>(table.numTerminals);
+    header.numNonTerminals = static_cast<uint32_t>(table.numNonTerminals);
+    header.actionStride = static_cast<uint32_t>(table.actionStride);
+    header.gotoStride = static_cast<uint32_t>(table.gotoStride);
+
+    header.symbolsOffset = out.size();
+    for (int sym = 0; sym < grammar.symbols.size(); ++sym) {
+        const string& name = grammar.symbols.name(sym);
+        appendRaw(out, static_cast<uint32_t>(grammar.symbols.kind(sym)));
+        appendRaw(out, static_cast<uint32_t>(name.size()));
+        out.insert(out.end(), name.begin(), name.end());
+    }
+
+    header.productionsOffset = out.size();
+    for (const auto& prod : grammar.productions) {
+        appendRaw(out, static_cast<int32_t>(prod.lhs));
+        appendRaw(out, static_cast<uint32_t>(prod.listAppend ? kListAppendFlag : 0u));
+        appendRaw(out, static_cast<uint32_t>(prod.rhs.size()));
+        for (int sym : prod.rhs) appendRaw(out, static_cast<int32_t>(sym));
+    }
+
+    // 两张表都按缓存行对齐，映射后可以直接当作数组使用
+    out.resize((out.size() + 63) / 64 * 64, 0);
+    header.actionOffset = out.size();
+    const char* actions = reinterpret_cast<const char*>(table.actionRows());
+    out.insert(out.end(), actions, actions + sizeof(PackedAction) * table.numStates * table.actionStride);
+
+    out.resize((out.size() + 63) / 64 * 64, 0);
+    header.gotoOffset = out.size();
+    const char* gotos = reinterpret_cast<const char*>(table.gotoRows());
+    out.insert(out.end(), gotos, gotos + sizeof(int32_t) * table.numStates * table.gotoStride);
+
+    header.fileSize = out.size();
+    header.checksum = fnv1a64(out.data() + sizeof(header), out.size() - sizeof(header));
+    memcpy(out.data(), &header, sizeof(header));
+
+    ofstream file(filename, ios::binary);
+    if (!file.is_open()) {
+        throw runtime_error("Failed to open file " + filename);
+    }
+    file.write(out.data(), static_cast<streamsize>(out.size()));
+    if (!file) {
+        throw runtime_error("Failed to write file " + filename);
+    }
+}
+
+// 映射二进制分析表文件：ACTION/GOTO表直接引用映射内存，不做复制，也不需要重新构造
+inline GrammarTables loadTableFile(const string& filename, bool verifyChecksum = true) {
+    shared_ptr<MappedFile> file = MappedFile::open(filename);
+    const char* data = file->data();
+    const size_t size = file->size();
+
+    TableFileHeader header;
+    if (size < sizeof(header)) {
+        throw runtime_error("Invalid table file " + filename + ": truncated header");
+    }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, kTableMagic, sizeof(kTableMagic)) != 0) {
+        throw runtime_error("Invalid table file " + filename + ": bad magic");
+    }
+    if (header.version != kTableVersion) {
+        throw runtime_error("Unsupported table file version " + to_string(header.version));
+    }
+    if (header.endianTag != kEndianTag) {
+        throw runtime_error("Table file " + filename + " was generated with a different byte order");
+    }
+    // 从offset起能否放下numStates行、每行stride个元素(用除法比较，避免乘法溢出)
+    auto sectionFits = [&](uint64_t offset, uint64_t stride, size_t elementSize) {
+        if (offset > size || offset % 64 != 0) return false;
+        return header.numStates == 0 || stride <= (size - offset) / elementSize / header.numStates;
+    };
+    if (header.fileSize != size || !sectionFits(header.actionOffset, header.actionStride, sizeof(PackedAction)) ||
+        !sectionFits(header.gotoOffset, header.gotoStride, sizeof(int32_t)) ||
+        header.symbolsOffset > header.productionsOffset || header.productionsOffset > header.actionOffset) {
+        throw runtime_error("Invalid table file " + filename + ": inconsistent layout");
+    }
+    // 查表时按终结符/非终结符编号直接索引行内元素，行宽必须容纳全部符号
+    if (header.numStates == 0 || header.numStates > INT32_MAX || header.numSymbols > INT32_MAX ||
+        header.actionStride < header.numTerminals ||
+        header.gotoStride < header.numNonTerminals ||
+        uint64_t(header.numTerminals) + header.numNonTerminals != header.numSymbols) {
+        throw runtime_error("Invalid table file " + filename + ": inconsistent table shape");
+    }
+    if (verifyChecksum && fnv1a64(data + sizeof(header), size - sizeof(header)) != header.checksum) {
+        throw runtime_error("Invalid table file " + filename + ": checksum mismatch");
+    }
+
+    auto readU32 = [&](uint64_t& offset) {
+        if (offset + sizeof(uint32_t) > header.actionOffset) {
+            throw runtime_error("Invalid table file " + filename + ": truncated section");
+        }
+        uint32_t value;
+        memcpy(&value, data + offset, sizeof(value));
+        offset += sizeof(value);
+        return value;
+    };
+
+    auto readSymbol = [&](uint64_t& offset) {
+        int32_t id = static_cast<int32_t>(readU32(offset));
+        if (id < 0 || id >= static_cast<int32_t>(header.numSymbols)) {
+            throw runtime_error("Invalid table file " + filename + ": bad symbol id");
+        }
+        return static_cast<int>(id);
+    };
+
+    GrammarTables grammar;
+    uint64_t offset = header.symbolsOffset;
+    for (uint32_t i = 0; i < header.numSymbols; ++i) {
+        SymbolKind kind = static_cast<SymbolKind>(readU32(offset));
+        uint32_t length = readU32(offset);
+        if (offset + length > header.productionsOffset) {
+            throw runtime_error("Invalid table file " + filename + ": truncated symbol");
+        }
+        // 终结符必须排在非终结符之前，且名字互不相同，符号ID才与分析表的列一致
+        const SymbolKind expected = i < header.numTerminals ? TERMINAL : NONTERMINAL;
+        if (kind != expected || grammar.symbols.intern(string(data + offset, length), kind) != static_cast<int>(i)) {
+            throw runtime_error("Invalid table file " + filename + ": bad symbol table");
+        }
+        offset += length;
+    }
+
+    offset = header.productionsOffset;
+    for (uint32_t i = 0; i < header.numProductions; ++i) {
+        int lhs = readSymbol(offset);
+        uint32_t flags = readU32(offset);
+        uint32_t length = readU32(offset);
+        if (!grammar.symbols.isNonTerminal(lhs) || length > (header.actionOffset - offset) / sizeof(int32_t)) {
+            throw runtime_error("Invalid table file " + filename + ": bad production");
+        }
+        vector<int> rhs(length);
+        vector<string> right;
+        for (uint32_t j = 0; j < length; ++j) {
+            rhs[j] = readSymbol(offset);
+            right.push_back(grammar.symbols.name(rhs[j]));
+        }
+        if (right.empty()) right.push_back("ε");
+
+        Production prod(grammar.symbols.name(lhs), right, static_cast<int>(i));
+        prod.lhs = lhs;
+        prod.rhs = move(rhs);
+        prod.listAppend = (flags & kListAppendFlag) != 0;
+        grammar.productions.push_back(move(prod));
+    }
+
+    // 列表L -> L X的节点在归约时原地追加子节点(见Arena::appendToArray)，L的其他产生式只能是L -> ε或L -> X
+    vector<bool> isList(header.numSymbols, false);
+    for (const Production& prod : grammar.productions) {
+        if (!prod.listAppend) continue;
+        if (prod.rhs.size() != 2 || prod.rhs[0] != prod.lhs) {
+            throw runtime_error("Invalid table file " + filename + ": bad list production");
+        }
+        isList[prod.lhs] = true;
+    }
+    for (const Production& prod : grammar.productions) {
+        if (isList[prod.lhs] && !prod.listAppend && prod.rhs.size() > 1) {
+            throw runtime_error("Invalid table file " + filename + ": bad list production");
+        }
+    }
+
+    // 表项中的状态和产生式编号在分析时直接用作下标，逐项检查范围
+    const PackedAction* actions = reinterpret_cast<const PackedAction*>(data + header.actionOffset);
+    const int32_t* gotos = reinterpret_cast<const int32_t*>(data + header.gotoOffset);
+    for (uint64_t state = 0; state < header.numStates; ++state) {
+        for (uint32_t terminal = 0; terminal < header.numTerminals; ++terminal) {
+            const TableAction action = unpackAction(actions[state * header.actionStride + terminal]);
+            if ((action.type == SHIFT && static_cast<uint32_t>(action.value) >= header.numStates) ||
+                (action.type == REDUCE && static_cast<uint32_t>(action.value) >= header.numProductions)) {
+                throw runtime_error("Invalid table file " + filename + ": ACTION entry out of range");
+            }
+        }
+        for (uint32_t nonTerminal = 0; nonTerminal < header.numNonTerminals; ++nonTerminal) {
+            const int32_t target = gotos[state * header.gotoStride + nonTerminal];
+            if (target < -1 || (target >= 0 && static_cast<uint32_t>(target) >= header.numStates)) {
+                throw runtime_error("Invalid table file " + filename + ": GOTO entry out of range");
+            }
+        }
+    }
+
+    grammar.table.attach(file, actions, gotos,
+                         static_cast<int>(header.numStates), static_cast<int>(header.numTerminals),
+                         static_cast<int>(header.numNonTerminals), header.actionStride, header.gotoStride);
+    return grammar;
+}
+
+// 输出C++字符串字面量(转义引号和反斜杠，其余字节原样保留)
+inline string cppStringLiteral(const string& text) {
+    string literal = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') literal += '\\';
+        literal += c;
+    }
+    return literal + "\"";
+}
+
+// 能容纳maxValue的最小无符号整数类型名
+inline const char* unsignedTypeFor(size_t maxValue) {
+    if (maxValue <= UINT8_MAX) return "uint8_t";
+    if (maxValue <= UINT16_MAX) return "uint16_t";
+    if (maxValue <= UINT32_MAX) return "uint32_t";
+    throw runtime_error("Value " + to_string(maxValue) + " does not fit in a generated table");
+}
+
+template <typename Fn>
+inline void writeArray(ofstream& file, const char* type, const char* name, size_t count, Fn&& element) {
+    file << "    static constexpr " << type << " " << name << "[] = {";
+    for (size_t i = 0; i < count; ++i) {
+        file << (i % 16 == 0 ? "\n        " : " ") << element(i) << ",";
+    }
+    file << "\n    };\n";
+}
+
+// 生成包含constexpr分析表的C++头文件，供StaticParser在编译期特化使用
+// ACTION表为 状态数 × 终结符数，GOTO表为 状态数 × 非终结符数，均不含行补齐
+inline void writeTableHeader(const string& filename, const GrammarTables& grammar,
+                             const string& structName = "GeneratedTables") {
+    const ParseTable& table = grammar.table;
+    ofstream file(filename);
+    if (!file.is_open()) {
+        throw runtime_error("Failed to open file " + filename);
+    }
+
+    const size_t numTerminals = table.numTerminals;
+    const size_t numNonTerminals = table.numNonTerminals;
+    file << "// 由tablegen生成，请勿手工修改\n"
+         << "#pragma once\n\n"
+         << "#include <cstdint>\n\n"
+         << "struct " << structName << " {\n"
+         << "    static constexpr int kNumStates = " << table.numStates << ";\n"
+         << "    static constexpr int kNumTerminals = " << table.numTerminals << ";\n"
+         << "    static constexpr int kNumNonTerminals = " << table.numNonTerminals << ";\n"
+         << "    static constexpr int kNumProductions = " << grammar.productions.size() << ";\n"
+         << "    static constexpr int kIdentifier = " << grammar.symbols.find("IDENTIFIER") << ";\n"
+         << "    static constexpr int kNumber = " << grammar.symbols.find("NUMBER") << ";\n"
+         << "    static constexpr int kString = " << grammar.symbols.find("STRING") << ";\n"
+         << "    static constexpr int kEnd = " << grammar.symbols.find("$") << ";\n\n";
+
+    // 符号名按ID排列；终结符按名字排序编号，因此前kNumTerminals项是有序的
+    writeArray(file, "const char*", "kSymbolNames", grammar.symbols.size(), [&](size_t i) {
+        return cppStringLiteral(grammar.symbols.name(static_cast<int>(i)));
+    });
+    // 产生式长度和左部ID按最大值选用能容纳的最小无符号类型，大文法不会被截断
+    size_t maxLength = 0;
+    size_t maxLhs = 0;
+    for (const auto& prod : grammar.productions) {
+        maxLength = max(maxLength, prod.rhs.size());
+        maxLhs = max(maxLhs, static_cast<size_t>(prod.lhs));
+    }
+    writeArray(file, unsignedTypeFor(maxLength), "kProdLength", grammar.productions.size(), [&](size_t i) {
+        return to_string(grammar.productions[i].rhs.size());
+    });
+    writeArray(file, unsignedTypeFor(maxLhs), "kProdLhs", grammar.productions.size(), [&](size_t i) {
+        return to_string(grammar.productions[i].lhs);
+    });
+    writeArray(file, "bool", "kProdListAppend", grammar.productions.size(), [&](size_t i) {
+        return grammar.productions[i].listAppend ? "true" : "false";
+    });
+    writeArray(file, "uint32_t", "kAction", table.numStates * numTerminals, [&](size_t i) {
+        return to_string(table.action(static_cast<int>(i / numTerminals), static_cast<int>(i % numTerminals))) + "u";
+    });
+    writeArray(file, "int32_t", "kGoto", table.numStates * numNonTerminals, [&](size_t i) {
+        return to_string(table.gotoState(static_cast<int>(i / numNonTerminals),
+                                         static_cast<int>(numTerminals + i % numNonTerminals)));
+    });
+    file << "};\n";
+
+    if (!file) {
+        throw runtime_error("Failed to write file " + filename);
+    }
+}
+
+#endif
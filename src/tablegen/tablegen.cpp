@@ -0,0 +1,120 @@
+// 分析表编译器：离线构造SLR(1)分析表并输出带版本号和校验和的二进制表文件，
+// 或输出包含constexpr分析表的C++头文件
+// 用法: tablegen [-g 文法文件] [-o 输出文件] [--tsv 可读表文件] [--header 头文件]
+// 未指定任何输出时默认写出slr_table.bin
+//
+// 文法文件格式(每行一条，#开头为注释)：
+//   %start S'
+//   %token IDENTIFIER NUMBER ; = ...
+//   Program -> Statements
+//   Statements -> Statement*
+// 右部的X*/X+表示零个/一个或多个X，建表时展开为左递归列表(见expandRepetitions)
+// 未指定文法文件时使用SyntaxParser的内置文法
+#include "../parser/parser.cpp"
+#include <cstdlib>
+#include <sstream>
+
+using namespace std;
+
+struct GrammarSource {
+    vector<Production> productions;
+    unordered_set<string> terminals;
+    string startSymbol;
+};
+
+static GrammarSource readGrammarFile(const string& filename) {
+    ifstream file(filename);
+    if (!file.is_open()) {
+        throw runtime_error("Failed to open grammar file " + filename);
+    }
+
+    GrammarSource grammar;
+    string line;
+    size_t lineNo = 0;
+    while (getline(file, line)) {
+        lineNo++;
+        istringstream in(line);
+        string first;
+        if (!(in >> first) || first[0] == '#') continue;
+
+        if (first == "%start") {
+            in >> grammar.startSymbol;
+        } else if (first == "%token") {
+            string term;
+            while (in >> term) grammar.terminals.insert(term);
+        } else {
+            string arrow;
+            if (!(in >> arrow) || arrow != "->") {
+                throw runtime_error(filename + ":" + to_string(lineNo) + ": expected '->'");
+            }
+            vector<string> right;
+            string sym;
+            while (in >> sym) right.push_back(sym);
+            if (right.empty()) right.push_back("ε");
+            grammar.productions.emplace_back(first, right, static_cast<int>(grammar.productions.size()));
+        }
+    }
+
+    if (grammar.productions.empty()) {
+        throw runtime_error("Grammar file " + filename + " has no productions");
+    }
+    // 未声明开始符号时，以第一条产生式的左部为开始符号
+    if (grammar.startSymbol.empty()) {
+        grammar.startSymbol = grammar.productions[0].left;
+    }
+    return grammar;
+}
+
+int main(int argc, char** argv) {
+    string grammarFile;
+    string outputFile;
+    string tsvFile;
+    string headerFile;
+    size_t jobs = thread::hardware_concurrency();
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if ((arg == "-g" || arg == "-o" || arg == "-j" || arg == "--tsv" || arg == "--header") && i + 1 < argc) {
+            string value = argv[++i];
+            if (arg == "-g") grammarFile = value;
+            else if (arg == "-o") outputFile = value;
+            else if (arg == "-j") jobs = static_cast<size_t>(atoi(value.c_str()));
+            else if (arg == "--tsv") tsvFile = value;
+            else headerFile = value;
+        } else {
+            cerr << "Usage: " << argv[0] << " [-g grammar] [-o output] [-j threads] [--tsv table.txt] [--header tables.h]" << endl;
+            return 2;
+        }
+    }
+    if (outputFile.empty() && tsvFile.empty() && headerFile.empty()) {
+        outputFile = "slr_table.bin";
+    }
+
+    try {
+        GrammarTables tables;
+        if (grammarFile.empty()) {
+            tables = SyntaxParser::buildSLRTable();
+        } else {
+            GrammarSource source = readGrammarFile(grammarFile);
+            tables = buildGrammarTables(source.productions,
+                                        SyntaxParser::getNonTerminals(source.productions),
+                                        source.terminals, source.startSymbol, jobs);
+        }
+
+        if (!outputFile.empty()) {
+            writeTableFile(outputFile, tables);
+            cout << "SLR table (" << tables.table.numStates << " states) has been saved to " << outputFile << endl;
+        }
+        if (!headerFile.empty()) {
+            writeTableHeader(headerFile, tables);
+            cout << "SLR table header has been saved to " << headerFile << endl;
+        }
+        if (!tsvFile.empty()) {
+            printTables(tables.table, tables.symbols, tsvFile);
+        }
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}